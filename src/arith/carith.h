@@ -2,13 +2,12 @@
 
 #include <common.h>
 #include <arith/basearith.h>
+#include <arith/codelet.h>
+#include <arith/simd.h>
 #include <complex.h>
+#include <algorithm>
 #include <utility>
 
-#if __AVX2__
-#include <immintrin.h>
-#endif
-
 
 template<typename T> requires ComplexType<T>
 struct carith {
@@ -87,6 +86,229 @@ struct carith {
         }
     };
 
+    struct _faltaddsubmult_t {
+        // O_a = a + b
+        // O_b = (a - b) * c
+        static inline void _exec(T& outa, T& outb, const RefType& a, const RefType& b, const RefType& c) noexcept {
+            T b_diff;
+            b_diff.re = a.re - b.re;
+            b_diff.im = a.im - b.im;
+
+            outa.re = a.re + b.re;
+            outa.im = a.im + b.im;
+            outb.re = b_diff.re * c.re - b_diff.im * c.im;
+            outb.im = b_diff.re * c.im + b_diff.im * c.re;
+        }
+    };
+
+    struct _fquadaddsub_op_t {
+        // Radix-4 decimation in time butterfly. The four inputs are quarter
+        // blocks in bit reversed order, meaning b holds the transform of the
+        // 4n+2 samples while c holds the transform of the 4n+1 samples
+        //
+        // t0 = a + b * w2, t1 = a - b * w2
+        // t2 = c * w1 + d * w3, t3 = c * w1 - d * w3
+        // O_a = t0 + t2, O_b = t1 - j * t3, O_c = t0 - t2, O_d = t1 + j * t3
+        static inline void _exec(T& outa, T& outb, T& outc, T& outd, const RefType& a, const RefType& b, 
+                const RefType& c, const RefType& d, const RefType& w1, const RefType& w2, const RefType& w3) noexcept {
+            T bw, cw, dw;
+            bw.re = b.re * w2.re - b.im * w2.im;
+            bw.im = b.re * w2.im + b.im * w2.re;
+            cw.re = c.re * w1.re - c.im * w1.im;
+            cw.im = c.re * w1.im + c.im * w1.re;
+            dw.re = d.re * w3.re - d.im * w3.im;
+            dw.im = d.re * w3.im + d.im * w3.re;
+
+            T t0, t1, t2, t3;
+            t0.re = a.re + bw.re;
+            t0.im = a.im + bw.im;
+            t1.re = a.re - bw.re;
+            t1.im = a.im - bw.im;
+            t2.re = cw.re + dw.re;
+            t2.im = cw.im + dw.im;
+            t3.re = cw.re - dw.re;
+            t3.im = cw.im - dw.im;
+
+            outa.re = t0.re + t2.re;
+            outa.im = t0.im + t2.im;
+            outb.re = t1.re + t3.im;
+            outb.im = t1.im - t3.re;
+            outc.re = t0.re - t2.re;
+            outc.im = t0.im - t2.im;
+            outd.re = t1.re - t3.im;
+            outd.im = t1.im + t3.re;
+        }
+    };
+
+    struct _fquadaddsubmult_t {
+        // Radix-4 decimation in frequency butterfly
+        //
+        // t0 = a + c, t1 = b + d
+        // t2 = a - c, t3 = -j * (b - d)
+        // O_a = t0 + t1, O_b = (t0 - t1) * w2, O_c = (t2 + t3) * w1, O_d = (t2 - t3) * w3
+        static inline void _exec(T& outa, T& outb, T& outc, T& outd, const RefType& a, const RefType& b, 
+                const RefType& c, const RefType& d, const RefType& w1, const RefType& w2, const RefType& w3) noexcept {
+            T t0, t1, t2, t3;
+            t0.re = a.re + c.re;
+            t0.im = a.im + c.im;
+            t1.re = b.re + d.re;
+            t1.im = b.im + d.im;
+            t2.re = a.re - c.re;
+            t2.im = a.im - c.im;
+            t3.re = b.im - d.im;
+            t3.im = d.re - b.re;
+
+            T db, dc, dd;
+            db.re = t0.re - t1.re;
+            db.im = t0.im - t1.im;
+            dc.re = t2.re + t3.re;
+            dc.im = t2.im + t3.im;
+            dd.re = t2.re - t3.re;
+            dd.im = t2.im - t3.im;
+
+            outa.re = t0.re + t1.re;
+            outa.im = t0.im + t1.im;
+            outb.re = db.re * w2.re - db.im * w2.im;
+            outb.im = db.re * w2.im + db.im * w2.re;
+            outc.re = dc.re * w1.re - dc.im * w1.im;
+            outc.im = dc.re * w1.im + dc.im * w1.re;
+            outd.re = dd.re * w3.re - dd.im * w3.im;
+            outd.im = dd.re * w3.im + dd.im * w3.re;
+        }
+    };
+
+    struct _fquadaddsubmultconj_t {
+        // Inverse of the radix-4 butterfly (scaled by 4)
+        //
+        // t0 = a + c, t1 = b + d
+        // t2 = a - c, t3 = j * (b - d)
+        // O_a = t0 + t1, O_b = (t0 - t1) * w2*, O_c = (t2 + t3) * w1*, O_d = (t2 - t3) * w3*
+        static inline void _exec(T& outa, T& outb, T& outc, T& outd, const RefType& a, const RefType& b, 
+                const RefType& c, const RefType& d, const RefType& w1, const RefType& w2, const RefType& w3) noexcept {
+            T t0, t1, t2, t3;
+            t0.re = a.re + c.re;
+            t0.im = a.im + c.im;
+            t1.re = b.re + d.re;
+            t1.im = b.im + d.im;
+            t2.re = a.re - c.re;
+            t2.im = a.im - c.im;
+            t3.re = d.im - b.im;
+            t3.im = b.re - d.re;
+
+            T db, dc, dd;
+            db.re = t0.re - t1.re;
+            db.im = t0.im - t1.im;
+            dc.re = t2.re + t3.re;
+            dc.im = t2.im + t3.im;
+            dd.re = t2.re - t3.re;
+            dd.im = t2.im - t3.im;
+
+            outa.re = t0.re + t1.re;
+            outa.im = t0.im + t1.im;
+            outb.re = db.re * w2.re + db.im * w2.im;
+            outb.im = db.im * w2.re - db.re * w2.im;
+            outc.re = dc.re * w1.re + dc.im * w1.im;
+            outc.im = dc.im * w1.re - dc.re * w1.im;
+            outd.re = dd.re * w3.re + dd.im * w3.im;
+            outd.im = dd.im * w3.re - dd.re * w3.im;
+        }
+    };
+
+    static FORCE_INLINE T _cadd(const T& a, const T& b) noexcept {
+        return T{a.re + b.re, a.im + b.im};
+    }
+
+    static FORCE_INLINE T _csub(const T& a, const T& b) noexcept {
+        return T{a.re - b.re, a.im - b.im};
+    }
+
+    static FORCE_INLINE T _cmul(const T& a, const T& b) noexcept {
+        return T{a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+    }
+
+    // j * a
+    static FORCE_INLINE T _cmulj(const T& a) noexcept {
+        return T{-a.im, a.re};
+    }
+
+    static FORCE_INLINE T _cscale(const T& a, BaseType c) noexcept {
+        return T{a.re * c, a.im * c};
+    }
+
+    // a * c + b, c is real
+    static FORCE_INLINE T _cfma(const T& a, BaseType c, const T& b) noexcept {
+        return T{a.re * c + b.re, a.im * c + b.im};
+    }
+
+    // a * (re + j * im), for factors known at compile time
+    static FORCE_INLINE T _cmulc(const T& a, BaseType re, BaseType im) noexcept {
+        return T{a.re * re - a.im * im, a.re * im + a.im * re};
+    }
+
+    // Radix R butterfly of a mixed radix stage, with a single set of twiddles for the whole range
+    // out[j] = (sum_k in[k] * W_R^jk) * tw[j], tw[0] is implicitly 1 unless Scaled
+    template <size_t R, bool Inverse, bool Scaled = false>
+    static inline void _fradix(OutputType* out, const InputType* in, const T* tw, const BaseType* cs, const BaseType* sn, size_t n) noexcept {
+        T x[R], y[R];
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = 0; k < R; k++) {
+                x[k] = T{in[k].re[i], in[k].im[i]};
+            }
+            codelet::radix_dft<carith, R, Inverse>(y, x, cs, sn);
+            out[0][i] = Scaled ? _cmul(y[0], tw[0]) : y[0];
+            for (size_t j = 1; j < R; j++) {
+                out[j][i] = _cmul(y[j], tw[j]);
+            }
+        }
+    }
+
+    // Radix R butterflies of a whole mixed radix stage of stride s, with a set of twiddles per butterfly
+    // Element f = s * p + q (butterfly p, position q < s) reads in[k][f] and writes output j to
+    // out[s * (R * p + j) + q], multiplied by tw[j - 1][f], conjugated when Inverse
+    // With Scaled, every output is also multiplied by scale
+    template <size_t R, bool Inverse, bool Scaled = false>
+    static inline void _fradix_lanes(OutputType out, const InputType* in, const InputType* tw, const BaseType* cs, const BaseType* sn, BaseType scale, size_t n, size_t s) noexcept {
+        T x[R], y[R];
+        size_t p = 0, q = 0;
+        for (size_t f = 0; f < n; f++) {
+            for (size_t k = 0; k < R; k++) {
+                x[k] = T{in[k].re[f], in[k].im[f]};
+            }
+            codelet::radix_dft<carith, R, Inverse>(y, x, cs, sn);
+            for (size_t j = 0; j < R; j++) {
+                T o = y[j];
+                if (j != 0) {
+                    o = _cmul(o, T{tw[j-1].re[f], Inverse ? -tw[j-1].im[f] : tw[j-1].im[f]});
+                }
+                out[s * (R * p + j) + q] = Scaled ? _cscale(o, scale) : o;
+            }
+            if (++q == s) {
+                q = 0;
+                p++;
+            }
+        }
+    }
+
+    // Fixed size transform of lanes independent signals, see arith/codelet.h
+    // Element i of signal l is at data[i * stride + l]
+    // With Reversed, the time domain side (input of the forward, output of the inverse) is in bit reversed order
+    // With Normalized, the outputs are divided by N within the last stage
+    template <size_t N, bool Inverse, bool Reversed = false, bool Normalized = false>
+    static inline void _fcodelet(OutputType data, size_t stride, size_t lanes) noexcept {
+        constexpr auto order = codelet::order<N, Reversed>;
+        T y[N];
+        for (size_t l = 0; l < lanes; l++) {
+            auto load = [&](size_t i) __attribute__((always_inline)) {
+                size_t k = Inverse ? i : order[i];
+                return T{data.re[k * stride + l], data.im[k * stride + l]}; 
+            };
+            codelet::dft<carith, N, Inverse, Normalized>(y, load);
+            for (size_t i = 0; i < N; i++) {
+                data[(Inverse ? order[i] : i) * stride + l] = y[i];
+            }
+        }
+    }
+
     template<typename Op, typename... Args>
     static inline void _vec_impl(Op, size_t n, OutputType& out, Args&&... args) noexcept {
         T _out;
@@ -106,6 +328,18 @@ struct carith {
         }
     }
 
+    template<typename Op, typename... Args>
+    static inline void _vec_impl_4(Op, size_t n, OutputType& outa, OutputType& outb, OutputType& outc, OutputType& outd, Args&&... args) noexcept {
+        T _outa, _outb, _outc, _outd;
+        for (size_t i = 0; i < n; i++) {
+            Op::_exec(_outa, _outb, _outc, _outd, args[i]...); 
+            outa[i] = _outa;
+            outb[i] = _outb;
+            outc[i] = _outc;
+            outd[i] = _outd;
+        }
+    }
+
     template <typename Op, typename... Args>
     static inline void _scalar_impl(Op, size_t n, OutputType& out, const InputType& a, const RefType& b) noexcept {
         T _out;
@@ -115,6 +349,29 @@ struct carith {
         }
     }
 
+    template <typename Op>
+    static inline void _scalar_impl_2(Op, size_t n, OutputType& outa, OutputType& outb, const InputType& a, const InputType& b, const RefType& c) noexcept {
+        T _outa, _outb;
+        for (size_t i = 0; i < n; i++) {
+            Op::_exec(_outa, _outb, a[i], b[i], c);
+            outa[i] = _outa;
+            outb[i] = _outb;
+        }
+    }
+
+    template <typename Op>
+    static inline void _scalar_impl_4(Op, size_t n, OutputType& outa, OutputType& outb, OutputType& outc, OutputType& outd, const InputType& a, 
+            const InputType& b, const InputType& c, const InputType& d, const RefType& w1, const RefType& w2, const RefType& w3) noexcept {
+        T _outa, _outb, _outc, _outd;
+        for (size_t i = 0; i < n; i++) {
+            Op::_exec(_outa, _outb, _outc, _outd, a[i], b[i], c[i], d[i], w1, w2, w3);
+            outa[i] = _outa;
+            outb[i] = _outb;
+            outc[i] = _outc;
+            outd[i] = _outd;
+        }
+    }
+
     static inline void _faltmaddsub_vec(OutputType outa, OutputType outb, InputType a, InputType b, InputType c, size_t n) noexcept {
         _vec_impl_2(_faltmaddsub_op_t{}, n, outa, outb, a, b, c);
     }
@@ -123,6 +380,39 @@ struct carith {
         _vec_impl_2(_faltaddsubmultconj_t{}, n, outa, outb, a, b, c);
     }
 
+    static inline void _faltaddsubmult_scalar(OutputType outa, OutputType outb, InputType a, InputType b, RefType c, size_t n) noexcept {
+        _scalar_impl_2(_faltaddsubmult_t{}, n, outa, outb, a, b, c);
+    }
+
+    static inline void _faltaddsubmultconj_scalar(OutputType outa, OutputType outb, InputType a, InputType b, RefType c, size_t n) noexcept {
+        _scalar_impl_2(_faltaddsubmultconj_t{}, n, outa, outb, a, b, c);
+    }
+
+    static inline void _fquadaddsubmult_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsubmult_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline void _fquadaddsubmultconj_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsubmultconj_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline void _fquadaddsub_vec(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, InputType w1, InputType w2, InputType w3, size_t n) noexcept {
+        _vec_impl_4(_fquadaddsub_op_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline void _fquadaddsub_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsub_op_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline void _fquadaddsubmultconj(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, InputType w1, InputType w2, InputType w3, size_t n) noexcept {
+        _vec_impl_4(_fquadaddsubmultconj_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
     static inline void _add_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
         _vec_impl(_add_op_t{}, n, out, a, b);
     }
@@ -140,18 +430,20 @@ struct carith {
     }
 };
 
-#if __AVX2__
-template<>
-struct carith<complex<double>> {
-
+#if __AVX2__ || SIMD_DISPATCH
+// SIMD backend, written once for every register type S of simd.h
+// Each register holds the real or imaginary parts of OpCapacity consecutive elements
+template <typename S>
+struct simd_carith {
 
-    using BaseType = double;
-    using BaseRegType = __m256d;
-    using OutputType = complexptr<double>;
-    using InputType = ccomplexptr<double>;
-    using RefType = ccomplexref<double>;
-    static constexpr size_t Alignment = sizeof(__m256d);
-    static constexpr size_t OpCapacity = (sizeof(__m256d) / sizeof(double));
+    using BaseType = S::BaseType;
+    using BaseRegType = S::Reg;
+    using AlgType = complex<BaseType>;
+    using OutputType = complexptr<BaseType>;
+    using InputType = ccomplexptr<BaseType>;
+    using RefType = ccomplexref<BaseType>;
+    static constexpr size_t Alignment = sizeof(BaseRegType);
+    static constexpr size_t OpCapacity = S::Width;
 
     // The new reg type to use
     struct RegType {
@@ -159,62 +451,74 @@ struct carith<complex<double>> {
         BaseRegType re;
         BaseRegType im;
 
-        constexpr RegType(const InputType& ref, size_t offset) noexcept {
-            re = _mm256_load_pd(ref.re + offset);
-            im = _mm256_load_pd(ref.im + offset);
+        FORCE_INLINE RegType(const InputType& ref, size_t offset) noexcept {
+            re = S::load(ref.re + offset);
+            im = S::load(ref.im + offset);
+        }
+
+        // Either simd::full or a mask of the lanes to read, the others are zero
+        template <typename M>
+        FORCE_INLINE RegType(const InputType& ref, size_t offset, M m) noexcept {
+            re = S::load(ref.re + offset, m);
+            im = S::load(ref.im + offset, m);
         }
 
-        constexpr RegType() noexcept {
+        FORCE_INLINE RegType() noexcept {
         }
 
-        constexpr void load(InputType& ref, size_t offset) noexcept {
-            re = _mm256_load_pd(ref.re + offset);
-            im = _mm256_load_pd(ref.im + offset);
+        FORCE_INLINE void load(InputType& ref, size_t offset) noexcept {
+            re = S::load(ref.re + offset);
+            im = S::load(ref.im + offset);
         }
 
-        constexpr void store(OutputType& ref, size_t offset) noexcept {
-            _mm256_store_pd(ref.re + offset, re);
-            _mm256_store_pd(ref.im + offset, im);
+        FORCE_INLINE void store(OutputType& ref, size_t offset) noexcept {
+            S::store(ref.re + offset, re);
+            S::store(ref.im + offset, im);
+        }
+
+        template <typename M>
+        FORCE_INLINE void store(OutputType& ref, size_t offset, M m) noexcept {
+            S::store(ref.re + offset, re, m);
+            S::store(ref.im + offset, im, m);
         }
     };
 
-    static_assert(OpCapacity == 4, "Bad assumption on SIMD register size");
 
     struct _add_op_t {
-        static inline void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
-            out.re = _mm256_add_pd(a.re, b.re);
-            out.im = _mm256_add_pd(a.im, b.im);
+        static FORCE_INLINE void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
+            out.re = S::add(a.re, b.re);
+            out.im = S::add(a.im, b.im);
         }
     };
 
     struct _sub_op_t {
-        static inline void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
-            out.re = _mm256_sub_pd(a.re, b.re);
-            out.im = _mm256_sub_pd(a.im, b.im);
+        static FORCE_INLINE void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
+            out.re = S::sub(a.re, b.re);
+            out.im = S::sub(a.im, b.im);
         }
     };
 
     struct _mul_op_t {
-        static inline void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
+        static FORCE_INLINE void _exec(RegType& out, const RegType& a, const RegType& b) noexcept {
             // Four mults and 2 adds necessary
             // aka 2 FMA and 2 mults
             // Cr = Ar * Br - Ai * Bi
             // Ci = Ar * Bi + Ai * Br
-            out.re = _mm256_fmsub_pd(a.re, b.re, _mm256_mul_pd(a.im, b.im));
-            out.im = _mm256_fmadd_pd(a.re, b.im, _mm256_mul_pd(a.im, b.re));
+            out.re = S::fmsub(a.re, b.re, S::mul(a.im, b.im));
+            out.im = S::fmadd(a.re, b.im, S::mul(a.im, b.re));
         }
     };
 
     struct _fma_op_t {
-        static inline void _exec(RegType& out, const RegType& a, 
+        static FORCE_INLINE void _exec(RegType& out, const RegType& a, 
                 const RegType& b, const RegType& c) noexcept {
             // Four mults and 4 adds necessary
             // Can compress into 4 FMA instructions!
             // D = A * B + C
             // Dr = Ar * Br - Ai * Bi + Cr
             // Di = Ar * Bi + Ai * Br + Ci
-            out.re = _mm256_fmsub_pd(a.re, b.re, _mm256_fmadd_pd(a.im, b.im, c.re));
-            out.im = _mm256_fmadd_pd(a.re, b.im, _mm256_fmadd_pd(a.im, b.re, c.im));
+            out.re = S::fmsub(a.re, b.re, S::fmadd(a.im, b.im, c.re));
+            out.im = S::fmadd(a.re, b.im, S::fmadd(a.im, b.re, c.im));
         }
     };
 
@@ -223,15 +527,15 @@ struct carith<complex<double>> {
         // O_s = a - b * c
 
         // O_a_r = a_r + (b_r * c_r - b_i * c_i)
-        static inline void _exec(RegType& outa, RegType& outb, const RegType& a, const RegType& b, const RegType& c) noexcept {
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, const RegType& a, const RegType& b, const RegType& c) noexcept {
             // Nothing yet
             RegType bc_prod;
-            bc_prod.re = _mm256_fmsub_pd(b.re, c.re, _mm256_mul_pd(b.im, c.im));
-            bc_prod.im = _mm256_fmadd_pd(b.re, c.im, _mm256_mul_pd(b.im, c.re));
-            outa.re = _mm256_add_pd(a.re, bc_prod.re);
-            outa.im = _mm256_add_pd(a.im, bc_prod.im);
-            outb.re = _mm256_sub_pd(a.re, bc_prod.re);
-            outb.im = _mm256_sub_pd(a.im, bc_prod.im);  
+            bc_prod.re = S::fmsub(b.re, c.re, S::mul(b.im, c.im));
+            bc_prod.im = S::fmadd(b.re, c.im, S::mul(b.im, c.re));
+            outa.re = S::add(a.re, bc_prod.re);
+            outa.im = S::add(a.im, bc_prod.im);
+            outb.re = S::sub(a.re, bc_prod.re);
+            outb.im = S::sub(a.im, bc_prod.im);  
         }
 
     };
@@ -239,21 +543,21 @@ struct carith<complex<double>> {
         // O_a = a + b
         // O_b = (a - b) * c* 
         // c* is the conjugation of c
-        static inline void _exec(RegType& outa, RegType& outb, const RegType& a, const RegType& b, const RegType& c) noexcept {
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, const RegType& a, const RegType& b, const RegType& c) noexcept {
             RegType ab_sum;
             RegType ab_diff;
-            ab_sum.re = _mm256_add_pd(a.re, b.re);
-            ab_sum.im = _mm256_add_pd(a.im, b.im);
+            ab_sum.re = S::add(a.re, b.re);
+            ab_sum.im = S::add(a.im, b.im);
 
             // ab_diff = (a-b)
-            ab_diff.re = _mm256_sub_pd(a.re, b.re);
-            ab_diff.im = _mm256_sub_pd(a.im, b.im);
+            ab_diff.re = S::sub(a.re, b.re);
+            ab_diff.im = S::sub(a.im, b.im);
 
             // Multiply by conjugation
             // a + jb * (c - jd) = ac + bd + j(bc - ad)
 
-            outb.re = _mm256_fmadd_pd(ab_diff.re, c.re, _mm256_mul_pd(ab_diff.im, c.im));
-            outb.im = _mm256_fmsub_pd(ab_diff.im, c.re, _mm256_mul_pd(ab_diff.re, c.im));
+            outb.re = S::fmadd(ab_diff.re, c.re, S::mul(ab_diff.im, c.im));
+            outb.im = S::fmsub(ab_diff.im, c.re, S::mul(ab_diff.re, c.im));
             
 
             // Pollute outa
@@ -262,53 +566,457 @@ struct carith<complex<double>> {
         }
     };
 
-    template<typename Op, typename... Args>
-    static inline void _vec_impl_2(Op, size_t n, OutputType& outa, OutputType& outb, Args&&... args) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(outa.re, outa.im, outb.re, outb.im, args.re..., args.im...));
-        RegType _outa, _outb;
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            Op::_exec(_outa, _outb, RegType(std::forward<Args>(args), offset)...);
-            _outa.store(outa, offset);
-            _outb.store(outb, offset);
+    struct _faltaddsubmult_t {
+        // O_a = a + b
+        // O_b = (a - b) * c
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, const RegType& a, const RegType& b, const RegType& c) noexcept {
+            RegType ab_diff;
+            ab_diff.re = S::sub(a.re, b.re);
+            ab_diff.im = S::sub(a.im, b.im);
+
+            outa.re = S::add(a.re, b.re);
+            outa.im = S::add(a.im, b.im);
+            outb.re = S::fmsub(ab_diff.re, c.re, S::mul(ab_diff.im, c.im));
+            outb.im = S::fmadd(ab_diff.re, c.im, S::mul(ab_diff.im, c.re));
         }
+    };
+
+    struct _fquadaddsub_op_t {
+        // Radix-4 butterfly, see the generic carith for the ordering of the blocks
+        // t0 = a + b * w2, t1 = a - b * w2
+        // t2 = c * w1 + d * w3, t3 = c * w1 - d * w3
+        // O_a = t0 + t2, O_b = t1 - j * t3, O_c = t0 - t2, O_d = t1 + j * t3
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, RegType& outc, RegType& outd, const RegType& a, const RegType& b, 
+                const RegType& c, const RegType& d, const RegType& w1, const RegType& w2, const RegType& w3) noexcept {
+            RegType bw, cw, dw;
+            bw.re = S::fmsub(b.re, w2.re, S::mul(b.im, w2.im));
+            bw.im = S::fmadd(b.re, w2.im, S::mul(b.im, w2.re));
+            cw.re = S::fmsub(c.re, w1.re, S::mul(c.im, w1.im));
+            cw.im = S::fmadd(c.re, w1.im, S::mul(c.im, w1.re));
+            dw.re = S::fmsub(d.re, w3.re, S::mul(d.im, w3.im));
+            dw.im = S::fmadd(d.re, w3.im, S::mul(d.im, w3.re));
+
+            RegType t0, t1, t2, t3;
+            t0.re = S::add(a.re, bw.re);
+            t0.im = S::add(a.im, bw.im);
+            t1.re = S::sub(a.re, bw.re);
+            t1.im = S::sub(a.im, bw.im);
+            t2.re = S::add(cw.re, dw.re);
+            t2.im = S::add(cw.im, dw.im);
+            t3.re = S::sub(cw.re, dw.re);
+            t3.im = S::sub(cw.im, dw.im);
+
+            outa.re = S::add(t0.re, t2.re);
+            outa.im = S::add(t0.im, t2.im);
+            outb.re = S::add(t1.re, t3.im);
+            outb.im = S::sub(t1.im, t3.re);
+            outc.re = S::sub(t0.re, t2.re);
+            outc.im = S::sub(t0.im, t2.im);
+            outd.re = S::sub(t1.re, t3.im);
+            outd.im = S::add(t1.im, t3.re);
+        }
+    };
+
+    struct _fquadaddsubmult_t {
+        // Radix-4 decimation in frequency butterfly
+        // t0 = a + c, t1 = b + d
+        // t2 = a - c, t3 = -j * (b - d)
+        // O_a = t0 + t1, O_b = (t0 - t1) * w2, O_c = (t2 + t3) * w1, O_d = (t2 - t3) * w3
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, RegType& outc, RegType& outd, const RegType& a, const RegType& b, 
+                const RegType& c, const RegType& d, const RegType& w1, const RegType& w2, const RegType& w3) noexcept {
+            RegType t0, t1, t2, t3;
+            t0.re = S::add(a.re, c.re);
+            t0.im = S::add(a.im, c.im);
+            t1.re = S::add(b.re, d.re);
+            t1.im = S::add(b.im, d.im);
+            t2.re = S::sub(a.re, c.re);
+            t2.im = S::sub(a.im, c.im);
+            t3.re = S::sub(b.im, d.im);
+            t3.im = S::sub(d.re, b.re);
+
+            RegType db, dc, dd;
+            db.re = S::sub(t0.re, t1.re);
+            db.im = S::sub(t0.im, t1.im);
+            dc.re = S::add(t2.re, t3.re);
+            dc.im = S::add(t2.im, t3.im);
+            dd.re = S::sub(t2.re, t3.re);
+            dd.im = S::sub(t2.im, t3.im);
+
+            outa.re = S::add(t0.re, t1.re);
+            outa.im = S::add(t0.im, t1.im);
+            outb.re = S::fmsub(db.re, w2.re, S::mul(db.im, w2.im));
+            outb.im = S::fmadd(db.re, w2.im, S::mul(db.im, w2.re));
+            outc.re = S::fmsub(dc.re, w1.re, S::mul(dc.im, w1.im));
+            outc.im = S::fmadd(dc.re, w1.im, S::mul(dc.im, w1.re));
+            outd.re = S::fmsub(dd.re, w3.re, S::mul(dd.im, w3.im));
+            outd.im = S::fmadd(dd.re, w3.im, S::mul(dd.im, w3.re));
+        }
+    };
+
+    struct _fquadaddsubmultconj_t {
+        // Inverse of the radix-4 butterfly (scaled by 4)
+        // t0 = a + c, t1 = b + d
+        // t2 = a - c, t3 = j * (b - d)
+        // O_a = t0 + t1, O_b = (t0 - t1) * w2*, O_c = (t2 + t3) * w1*, O_d = (t2 - t3) * w3*
+        static FORCE_INLINE void _exec(RegType& outa, RegType& outb, RegType& outc, RegType& outd, const RegType& a, const RegType& b, 
+                const RegType& c, const RegType& d, const RegType& w1, const RegType& w2, const RegType& w3) noexcept {
+            RegType t0, t1, t2, t3;
+            t0.re = S::add(a.re, c.re);
+            t0.im = S::add(a.im, c.im);
+            t1.re = S::add(b.re, d.re);
+            t1.im = S::add(b.im, d.im);
+            t2.re = S::sub(a.re, c.re);
+            t2.im = S::sub(a.im, c.im);
+            t3.re = S::sub(d.im, b.im);
+            t3.im = S::sub(b.re, d.re);
+
+            RegType db, dc, dd;
+            db.re = S::sub(t0.re, t1.re);
+            db.im = S::sub(t0.im, t1.im);
+            dc.re = S::add(t2.re, t3.re);
+            dc.im = S::add(t2.im, t3.im);
+            dd.re = S::sub(t2.re, t3.re);
+            dd.im = S::sub(t2.im, t3.im);
+
+            outa.re = S::add(t0.re, t1.re);
+            outa.im = S::add(t0.im, t1.im);
+            outb.re = S::fmadd(db.re, w2.re, S::mul(db.im, w2.im));
+            outb.im = S::fmsub(db.im, w2.re, S::mul(db.re, w2.im));
+            outc.re = S::fmadd(dc.re, w1.re, S::mul(dc.im, w1.im));
+            outc.im = S::fmsub(dc.im, w1.re, S::mul(dc.re, w1.im));
+            outd.re = S::fmadd(dd.re, w3.re, S::mul(dd.im, w3.im));
+            outd.im = S::fmsub(dd.im, w3.re, S::mul(dd.re, w3.im));
+        }
+    };
+
+    static FORCE_INLINE RegType _cadd(const RegType& a, const RegType& b) noexcept {
+        RegType out;
+        out.re = S::add(a.re, b.re);
+        out.im = S::add(a.im, b.im);
+        return out;
     }
 
-    template<typename Op, typename... Args>
-    static inline void _vec_impl(Op, size_t n, OutputType out, Args&&... args) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(out.re, out.im, args.re..., args.im...));
-        RegType _out;
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            Op::_exec(_out, RegType(std::forward<Args>(args), offset)...);
-            _mm256_store_pd(&out.re[offset], _out.re);
-            _mm256_store_pd(&out.im[offset], _out.im);
+    static FORCE_INLINE RegType _csub(const RegType& a, const RegType& b) noexcept {
+        RegType out;
+        out.re = S::sub(a.re, b.re);
+        out.im = S::sub(a.im, b.im);
+        return out;
+    }
+
+    static FORCE_INLINE RegType _cmul(const RegType& a, const RegType& b) noexcept {
+        RegType out;
+        out.re = S::fmsub(a.re, b.re, S::mul(a.im, b.im));
+        out.im = S::fmadd(a.re, b.im, S::mul(a.im, b.re));
+        return out;
+    }
+
+    // j * a
+    static FORCE_INLINE RegType _cmulj(const RegType& a) noexcept {
+        RegType out;
+        out.re = S::sub(S::zero(), a.im);
+        out.im = a.re;
+        return out;
+    }
+
+    static FORCE_INLINE RegType _cscale(const RegType& a, const BaseRegType& c) noexcept {
+        RegType out;
+        out.re = S::mul(a.re, c);
+        out.im = S::mul(a.im, c);
+        return out;
+    }
+
+    // a * c, for factors known at compile time
+    static FORCE_INLINE RegType _cscale(const RegType& a, BaseType c) noexcept {
+        return _cscale(a, S::set1(c));
+    }
+
+    // a * c + b, c is real
+    static FORCE_INLINE RegType _cfma(const RegType& a, const BaseRegType& c, const RegType& b) noexcept {
+        RegType out;
+        out.re = S::fmadd(a.re, c, b.re);
+        out.im = S::fmadd(a.im, c, b.im);
+        return out;
+    }
+
+    // a * (re + j * im), for factors known at compile time
+    static FORCE_INLINE RegType _cmulc(const RegType& a, BaseType re, BaseType im) noexcept {
+        BaseRegType _re = S::set1(re);
+        BaseRegType _im = S::set1(im);
+        RegType out;
+        out.re = S::fmsub(a.re, _re, S::mul(a.im, _im));
+        out.im = S::fmadd(a.re, _im, S::mul(a.im, _re));
+        return out;
+    }
+
+    // Scalar counterparts for the ranges that do not fill a register
+    static FORCE_INLINE AlgType _cadd(const AlgType& a, const AlgType& b) noexcept {
+        return AlgType{a.re + b.re, a.im + b.im};
+    }
+
+    static FORCE_INLINE AlgType _csub(const AlgType& a, const AlgType& b) noexcept {
+        return AlgType{a.re - b.re, a.im - b.im};
+    }
+
+    static FORCE_INLINE AlgType _cmul(const AlgType& a, const AlgType& b) noexcept {
+        return AlgType{a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+    }
+
+    static FORCE_INLINE AlgType _cmulj(const AlgType& a) noexcept {
+        return AlgType{-a.im, a.re};
+    }
+
+    static FORCE_INLINE AlgType _cscale(const AlgType& a, BaseType c) noexcept {
+        return AlgType{a.re * c, a.im * c};
+    }
+
+    static FORCE_INLINE AlgType _cfma(const AlgType& a, BaseType c, const AlgType& b) noexcept {
+        return AlgType{a.re * c + b.re, a.im * c + b.im};
+    }
+
+    static FORCE_INLINE AlgType _cmulc(const AlgType& a, BaseType re, BaseType im) noexcept {
+        return AlgType{a.re * re - a.im * im, a.re * im + a.im * re};
+    }
+
+    // Radix R butterfly of a mixed radix stage, with a single set of twiddles for the whole range
+    // out[j] = (sum_k in[k] * W_R^jk) * tw[j], tw[0] is implicitly 1 unless Scaled
+    // The registers hold consecutive positions of the same butterfly, see _fradix_lanes for strides below OpCapacity
+    // Legs that are not aligned to the register size (strides not divisible by OpCapacity) are read and written unaligned
+    template <size_t R, bool Inverse, bool Scaled = false>
+    static inline SIMD_CLONES void _fradix(OutputType* out, const InputType* in, const AlgType* tw, const BaseType* cs, const BaseType* sn, size_t n) noexcept {
+        constexpr size_t H = R / 2;
+        bool aligned = true;
+        for (size_t k = 0; k < R; k++) {
+            aligned = aligned && autil::_assert_align<Alignment>(in[k].re, in[k].im, out[k].re, out[k].im);
+        }
+
+        RegType _tw[R];
+        BaseRegType _cs[H * H + 1], _sn[H * H + 1];
+        for (size_t j = Scaled ? 0 : 1; j < R; j++) {
+            _tw[j].re = S::set1(tw[j].re);
+            _tw[j].im = S::set1(tw[j].im);
+        }
+        for (size_t i = 0; i < H * H; i++) {
+            _cs[i] = S::set1(cs[i]);
+            _sn[i] = S::set1(sn[i]);
+        }
+
+        auto butterfly = [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType x[R], y[R];
+            for (size_t k = 0; k < R; k++) {
+                x[k] = RegType(in[k], offset, m);
+            }
+            codelet::radix_dft<simd_carith, R, Inverse>(y, x, _cs, _sn);
+            (Scaled ? _cmul(y[0], _tw[0]) : y[0]).store(out[0], offset, m);
+            for (size_t j = 1; j < R; j++) {
+                _cmul(y[j], _tw[j]).store(out[j], offset, m);
+            }
+        };
+
+        if (aligned) {
+            simd::for_each_reg<S>(n, butterfly);
+            return;
+        }
+        // A mask of every lane, which lifts the alignment requirement of the whole registers
+        auto all = S::mask(OpCapacity);
+        size_t nvec = n / OpCapacity;
+        for (size_t i = 0; i < nvec; i++) {
+            butterfly(OpCapacity * i, all);
+        }
+        if (n % OpCapacity != 0) {
+            butterfly(OpCapacity * nvec, S::mask(n % OpCapacity));
         }
     }
 
-    template <typename Op> 
-    static inline void _scalar_impl(Op, size_t n, OutputType& out, InputType& a, RefType& b) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(out.re, out.im, a.re, a.im));
-        RegType _b, _out;
-        _b.re = _mm256_broadcast_sd(&b.re);
-        _b.im = _mm256_broadcast_sd(&b.im);
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            Op::_exec(_out, RegType(a, offset), _b);
-            _mm256_store_pd(&out.re[offset], _out.re);
-            _mm256_store_pd(&out.im[offset], _out.im);
+    // Radix R butterflies of a whole mixed radix stage of stride s, with a set of twiddles per butterfly
+    // Element f = s * p + q (butterfly p, position q < s) reads in[k][f] and writes output j to
+    // out[s * (R * p + j) + q], multiplied by tw[j - 1][f], conjugated when Inverse
+    // With Scaled, every output is also multiplied by scale
+    //
+    // Each lane runs its own butterfly, for the strides that cannot fill a register in _fradix
+    // The inputs and twiddles are contiguous in f and are read whole, while the outputs of a
+    // register are R * s apart every s elements and are scattered lane by lane
+    template <size_t R, bool Inverse, bool Scaled = false>
+    static inline SIMD_CLONES void _fradix_lanes(OutputType out, const InputType* in, const InputType* tw, const BaseType* cs, const BaseType* sn, BaseType scale, size_t n, size_t s) noexcept {
+        constexpr size_t H = R / 2;
+        BaseRegType _cs[H * H + 1], _sn[H * H + 1];
+        for (size_t i = 0; i < H * H; i++) {
+            _cs[i] = S::set1(cs[i]);
+            _sn[i] = S::set1(sn[i]);
+        }
+        BaseRegType _scale = S::set1(scale);
+
+        BaseType re[R][OpCapacity], im[R][OpCapacity];
+        RegType x[R], y[R];
+        size_t p = 0, q = 0;
+        for (size_t f = 0; f < n; f += OpCapacity) {
+            size_t lanes = std::min(OpCapacity, n - f);
+            auto m = S::mask(lanes);
+            for (size_t k = 0; k < R; k++) {
+                x[k] = RegType(in[k], f, m);
+            }
+            codelet::radix_dft<simd_carith, R, Inverse>(y, x, _cs, _sn);
+            for (size_t j = 0; j < R; j++) {
+                RegType o = y[j];
+                if (j != 0) {
+                    RegType w(tw[j-1], f, m);
+                    if constexpr (Inverse) {
+                        w.im = S::sub(S::zero(), w.im);
+                    }
+                    o = _cmul(o, w);
+                }
+                if constexpr (Scaled) {
+                    o = _cscale(o, _scale);
+                }
+                // Whole registers to the stack, which is cheaper than a store lane by lane
+                __builtin_memcpy(re[j], &o.re, sizeof(BaseRegType));
+                __builtin_memcpy(im[j], &o.im, sizeof(BaseRegType));
+            }
+
+            for (size_t l = 0; l < lanes; l++) {
+                for (size_t j = 0; j < R; j++) {
+                    out.re[s * (R * p + j) + q] = re[j][l];
+                    out.im[s * (R * p + j) + q] = im[j][l];
+                }
+                if (++q == s) {
+                    q = 0;
+                    p++;
+                }
+            }
         }
     }
 
-    static inline void _add_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
+    // Fixed size transform of lanes independent signals, see arith/codelet.h
+    // Element i of signal l is at data[i * stride + l]
+    // Groups of OpCapacity lanes are kept in registers when the rows are aligned, the rest is scalar
+    // With Normalized, the outputs are divided by N within the last stage
+    template <size_t N, bool Inverse, bool Reversed = false, bool Normalized = false>
+    static inline SIMD_CLONES void _fcodelet(OutputType data, size_t stride, size_t lanes) noexcept {
+        constexpr auto order = codelet::order<N, Reversed>;
+        size_t nvec = 0;
+        if (stride % OpCapacity == 0 && autil::_assert_align<Alignment>(data.re, data.im)) {
+            nvec = lanes / OpCapacity;
+        }
+
+        InputType in = data;
+        for (size_t v = 0; v < nvec; v++) {
+            RegType y[N];
+            auto load = [&](size_t i) __attribute__((always_inline)) { 
+                size_t k = Inverse ? i : order[i];
+                return RegType(in, k * stride + v * OpCapacity); 
+            };
+            codelet::dft<simd_carith, N, Inverse, Normalized>(y, load);
+            for (size_t i = 0; i < N; i++) {
+                y[i].store(data, (Inverse ? order[i] : i) * stride + v * OpCapacity);
+            }
+        }
+
+        AlgType y[N];
+        for (size_t l = nvec * OpCapacity; l < lanes; l++) {
+            auto load = [&](size_t i) __attribute__((always_inline)) { 
+                size_t k = Inverse ? i : order[i];
+                return AlgType{data.re[k * stride + l], data.im[k * stride + l]}; 
+            };
+            codelet::dft<simd_carith, N, Inverse, Normalized>(y, load);
+            for (size_t i = 0; i < N; i++) {
+                data[(Inverse ? order[i] : i) * stride + l] = y[i];
+            }
+        }
+    }
+
+    // Whole registers use aligned loads, ranges shorter than a register may start anywhere
+    // The remainder of every range is masked, nothing past n is read or written
+    template<typename Op, typename... Args>
+    static FORCE_INLINE void _vec_impl_4(Op, size_t n, OutputType& outa, OutputType& outb, OutputType& outc, OutputType& outd, Args&&... args) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(outa.re, outa.im, outb.re, outb.im, outc.re, outc.im, outd.re, outd.im, args.re..., args.im...));
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _outa, _outb, _outc, _outd;
+            Op::_exec(_outa, _outb, _outc, _outd, RegType(args, offset, m)...);
+            _outa.store(outa, offset, m);
+            _outb.store(outb, offset, m);
+            _outc.store(outc, offset, m);
+            _outd.store(outd, offset, m);
+        });
+    }
+
+    template<typename Op, typename... Args>
+    static FORCE_INLINE void _vec_impl_2(Op, size_t n, OutputType& outa, OutputType& outb, Args&&... args) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(outa.re, outa.im, outb.re, outb.im, args.re..., args.im...));
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _outa, _outb;
+            Op::_exec(_outa, _outb, RegType(args, offset, m)...);
+            _outa.store(outa, offset, m);
+            _outb.store(outb, offset, m);
+        });
+    }
+
+    template<typename Op, typename... Args>
+    static FORCE_INLINE void _vec_impl(Op, size_t n, OutputType out, Args&&... args) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(out.re, out.im, args.re..., args.im...));
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _out;
+            Op::_exec(_out, RegType(args, offset, m)...);
+            _out.store(out, offset, m);
+        });
+    }
+
+    template <typename Op> 
+    static FORCE_INLINE void _scalar_impl(Op, size_t n, OutputType& out, InputType& a, RefType& b) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(out.re, out.im, a.re, a.im));
+        RegType _b;
+        _b.re = S::set1(b.re);
+        _b.im = S::set1(b.im);
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _out;
+            Op::_exec(_out, RegType(a, offset, m), _b);
+            _out.store(out, offset, m);
+        });
+    }
+
+    template <typename Op> 
+    static FORCE_INLINE void _scalar_impl_2(Op, size_t n, OutputType& outa, OutputType& outb, InputType& a, InputType& b, RefType& c) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(outa.re, outa.im, outb.re, outb.im, a.re, a.im, b.re, b.im));
+        RegType _c;
+        _c.re = S::set1(c.re);
+        _c.im = S::set1(c.im);
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _outa, _outb;
+            Op::_exec(_outa, _outb, RegType(a, offset, m), RegType(b, offset, m), _c);
+            _outa.store(outa, offset, m);
+            _outb.store(outb, offset, m);
+        });
+    }
+
+    template <typename Op> 
+    static FORCE_INLINE void _scalar_impl_4(Op, size_t n, OutputType& outa, OutputType& outb, OutputType& outc, OutputType& outd, InputType& a, 
+            InputType& b, InputType& c, InputType& d, RefType& w1, RefType& w2, RefType& w3) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(outa.re, outa.im, outb.re, outb.im, outc.re, outc.im, outd.re, outd.im, 
+                    a.re, a.im, b.re, b.im, c.re, c.im, d.re, d.im));
+        RegType _w1, _w2, _w3;
+        _w1.re = S::set1(w1.re);
+        _w1.im = S::set1(w1.im);
+        _w2.re = S::set1(w2.re);
+        _w2.im = S::set1(w2.im);
+        _w3.re = S::set1(w3.re);
+        _w3.im = S::set1(w3.im);
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _outa, _outb, _outc, _outd;
+            Op::_exec(_outa, _outb, _outc, _outd, RegType(a, offset, m), RegType(b, offset, m), RegType(c, offset, m), RegType(d, offset, m), _w1, _w2, _w3);
+            _outa.store(outa, offset, m);
+            _outb.store(outb, offset, m);
+            _outc.store(outc, offset, m);
+            _outd.store(outd, offset, m);
+        });
+    }
+
+    static inline SIMD_CLONES void _add_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
         _vec_impl(_add_op_t{}, n, out, a, b);
     }
 
-    static inline void _sub_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
+    static inline SIMD_CLONES void _sub_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
         _vec_impl(_sub_op_t{}, n, out, a, b);
     }
 
-    static inline void _mul_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
+    static inline SIMD_CLONES void _mul_vec(OutputType out, InputType a, InputType b, size_t n) noexcept {
         _vec_impl(_mul_op_t{}, n, out, a, b);
     }
 
@@ -319,24 +1027,94 @@ struct carith<complex<double>> {
     // It is used to compute the butterfly of the FFT without
     // having to go through multiple operations (linear memory lookup benefits)
     // faltaddsub stands for "Fused alternating Multiplied add/subtract"
-    static inline void _faltmaddsub_vec(OutputType outa, OutputType outb, InputType a, InputType b, InputType c, size_t n) noexcept {
+    static inline SIMD_CLONES void _faltmaddsub_vec(OutputType outa, OutputType outb, InputType a, InputType b, InputType c, size_t n) noexcept {
         _vec_impl_2(_faltmaddsub_op_t{}, n, outa, outb, a, b, c);
     }
 
-    static inline void _faltaddsubmultconj(OutputType outa, OutputType outb, InputType a, InputType b, InputType c, size_t n) noexcept {
+    static inline SIMD_CLONES void _faltaddsubmultconj(OutputType outa, OutputType outb, InputType a, InputType b, InputType c, size_t n) noexcept {
         _vec_impl_2(_faltaddsubmultconj_t{}, n, outa, outb, a, b, c);
         // _vec_impl_tup(_faltaddsubmultconj_t{}, n, outa, outb, a, b, c);
     }
 
+    // O_a = a + b
+    // O_b = (a - b) * c (or c*), where c is a single factor for the whole range
+    // Out of place butterfly used by the Stockham autosort FFT
+    static inline SIMD_CLONES void _faltaddsubmult_scalar(OutputType outa, OutputType outb, InputType a, InputType b, RefType c, size_t n) noexcept {
+        _scalar_impl_2(_faltaddsubmult_t{}, n, outa, outb, a, b, c);
+    }
+
+    static inline SIMD_CLONES void _faltaddsubmultconj_scalar(OutputType outa, OutputType outb, InputType a, InputType b, RefType c, size_t n) noexcept {
+        _scalar_impl_2(_faltaddsubmultconj_t{}, n, outa, outb, a, b, c);
+    }
+
+    // Radix-4 decimation in frequency butterflies with a single set of twiddles for the whole range
+    static inline SIMD_CLONES void _fquadaddsubmult_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsubmult_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline SIMD_CLONES void _fquadaddsubmultconj_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsubmultconj_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    // Radix-4 butterfly over four quarter blocks, twiddled by w^k, w^2k and w^3k
+    // Used to merge two radix-2 layers of the FFT into a single pass over memory
+    static inline SIMD_CLONES void _fquadaddsub_vec(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, InputType w1, InputType w2, InputType w3, size_t n) noexcept {
+        _vec_impl_4(_fquadaddsub_op_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    // Same as above with a single set of twiddles for the whole range
+    static inline SIMD_CLONES void _fquadaddsub_scalar(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, RefType w1, RefType w2, RefType w3, size_t n) noexcept {
+        _scalar_impl_4(_fquadaddsub_op_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
+    static inline SIMD_CLONES void _fquadaddsubmultconj(OutputType outa, OutputType outb, OutputType outc, OutputType outd, InputType a, InputType b, 
+            InputType c, InputType d, InputType w1, InputType w2, InputType w3, size_t n) noexcept {
+        _vec_impl_4(_fquadaddsubmultconj_t{}, n, outa, outb, outc, outd, a, b, c, d, w1, w2, w3);
+    }
+
     // FMA
     // D = A*B + C
-    static inline void _fma_vec(OutputType out, InputType a, InputType b, InputType c, size_t n) noexcept { 
+    static inline SIMD_CLONES void _fma_vec(OutputType out, InputType a, InputType b, InputType c, size_t n) noexcept { 
         _vec_impl(_fma_op_t{}, n, out, a, b, c);
     }
     
-    static inline void _mul_scalar(OutputType out, InputType a, RefType b, size_t n) noexcept {
+    static inline SIMD_CLONES void _mul_scalar(OutputType out, InputType a, RefType b, size_t n) noexcept {
         _scalar_impl(_mul_op_t{}, n, out, a, b);
     }
 };
 
+#if __AVX512F__
+template<>
+struct carith<complex<double>> : simd_carith<simd::avx512<double>> {
+    static_assert(OpCapacity == 8, "Bad assumption on SIMD register size");
+};
+
+template<>
+struct carith<complex<float>> : simd_carith<simd::avx512<float>> {
+    static_assert(OpCapacity == 16, "Bad assumption on SIMD register size");
+};
+#elif __AVX2__
+template<>
+struct carith<complex<double>> : simd_carith<simd::avx2<double>> {
+    static_assert(OpCapacity == 4, "Bad assumption on SIMD register size");
+};
+
+template<>
+struct carith<complex<float>> : simd_carith<simd::avx2<float>> {
+    static_assert(OpCapacity == 8, "Bad assumption on SIMD register size");
+};
+#else
+template<>
+struct carith<complex<double>> : simd_carith<simd::vext<double>> {
+};
+
+template<>
+struct carith<complex<float>> : simd_carith<simd::vext<float>> {
+};
+#endif
+
 #endif
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <common.h>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// Straight line transforms of a fixed power of two size
+//
+// The codelets are written once against an arithmetic backend A (one of the carith
+// structs) and a value type V, which is either a single complex value or a SIMD
+// register holding one element of several independent signals. Every index, twiddle
+// factor and loop trip count is known at compile time, so a codelet unrolls into a
+// flat sequence of butterflies on locals with no table lookups.
+//
+// The transform is a radix-4 decimation in time. The input is read in natural order
+// with a compile time stride, which places the reordering of the sub transforms in
+// the recursion instead of a separate bit reversal pass.
+//
+// Up to UNROLL_MAX every butterfly is unrolled. Past that the sixteen registers are
+// long exhausted, and the outer stages run as loops over a compile time twiddle table,
+// which keeps the spilled values from being shuffled around the stack.
+//
+// A divisor D of the inverse (1/N for a normalized transform) is folded into the
+// twiddles of the last stage, the legs without a twiddle take one extra scaling.
+namespace codelet {
+
+    // Largest transform whose combining butterflies are fully unrolled
+    inline constexpr size_t UNROLL_MAX = 16;
+
+    inline constexpr double PI = 3.14159265358979323846;
+
+    // Series for sin(x) and cos(x), accurate to rounding for |x| <= pi/4
+    constexpr double _sin_series(double x) {
+        double term = x, sum = x;
+        for (int k = 1; k < 12; k++) {
+            term *= -x * x / ((2 * k) * (2 * k + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double _cos_series(double x) {
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k < 12; k++) {
+            term *= -x * x / ((2 * k - 1) * (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // cos(2pi e/n) and sin(2pi e/n), folded into [0, pi/4] with exact integer arithmetic
+    // n must be divisible by 8
+    constexpr std::pair<double, double> _unit(size_t e, size_t n) {
+        e %= n;
+        if (2 * e > n) {
+            auto [c, s] = _unit(n - e, n);
+            return {c, -s};
+        }
+        if (4 * e > n) {
+            auto [c, s] = _unit(e - n / 4, n);
+            return {-s, c};
+        }
+        if (8 * e > n) {
+            auto [c, s] = _unit(n / 4 - e, n);
+            return {s, c};
+        }
+        double x = 2.0 * PI * (1.0 * e) / (1.0 * n);
+        return {_cos_series(x), _sin_series(x)};
+    }
+
+    // Storage order of N elements, the bit reversal of [0, N) when Reversed
+    template <size_t N, bool Reversed>
+    inline constexpr auto order = [] {
+        std::array<size_t, N> out{};
+        for (size_t i = 0; i < N; i++) {
+            size_t r = 0;
+            for (size_t b = 1; b < N; b <<= 1) {
+                r = (r << 1) | ((i & b) ? 1 : 0);
+            }
+            out[i] = Reversed ? r : i;
+        }
+        return out;
+    }();
+
+    // W_N^E / D, the conjugate when Inverse
+    template <size_t N, size_t E, bool Inverse, size_t D = 1>
+    struct Twiddle {
+        static constexpr auto _cs = _unit(8 * E, 8 * N);
+        static constexpr double re = _cs.first / (1.0 * D);
+        static constexpr double im = (Inverse ? _cs.second : -_cs.second) / (1.0 * D);
+    };
+
+    template <typename A, size_t N, size_t E, bool Inverse, size_t D = 1, typename V>
+    FORCE_INLINE V _twiddle(const V& x) noexcept {
+        if constexpr (E % N == 0 && D == 1) {
+            return x;
+        } else if constexpr (E % N == 0) {
+            return A::_cscale(x, 1.0 / (1.0 * D));
+        } else {
+            using Tw = Twiddle<N, E % N, Inverse, D>;
+            return A::_cmulc(x, Tw::re, Tw::im);
+        }
+    }
+
+    // Combines the four sub transforms of length N/4 at out[0], out[N/4], ... into element K
+    // of each quarter of the length N transform
+    template <typename A, size_t N, size_t K, bool Inverse, size_t D, typename V>
+    FORCE_INLINE void _butterfly(V* out) noexcept {
+        constexpr size_t M = N / 4;
+        V a = _twiddle<A, N, 0, Inverse, D>(out[K]);
+        V b = _twiddle<A, N, K, Inverse, D>(out[K + M]);
+        V c = _twiddle<A, N, 2 * K, Inverse, D>(out[K + 2 * M]);
+        V d = _twiddle<A, N, 3 * K, Inverse, D>(out[K + 3 * M]);
+
+        V t0 = A::_cadd(a, c);
+        V t1 = A::_cadd(b, d);
+        V t2 = A::_csub(a, c);
+        V t3 = A::_cmulj(A::_csub(b, d));
+        out[K] = A::_cadd(t0, t1);
+        out[K + 2 * M] = A::_csub(t0, t1);
+        out[K + M] = Inverse ? A::_cadd(t2, t3) : A::_csub(t2, t3);
+        out[K + 3 * M] = Inverse ? A::_csub(t2, t3) : A::_cadd(t2, t3);
+    }
+
+    template <size_t N, bool Inverse, size_t D>
+    struct TwiddleTable {
+        static constexpr auto _make() {
+            std::array<double, 6 * (N / 4)> t{};
+            for (size_t k = 0; k < N / 4; k++) {
+                for (size_t j = 1; j <= 3; j++) {
+                    auto [c, s] = _unit(8 * j * k, 8 * N);
+                    t[6 * k + 2 * (j - 1)] = c / (1.0 * D);
+                    t[6 * k + 2 * (j - 1) + 1] = (Inverse ? s : -s) / (1.0 * D);
+                }
+            }
+            return t;
+        }
+        static constexpr auto values = _make();
+    };
+
+    template <typename A, size_t N, bool Inverse, size_t D, typename V>
+    FORCE_INLINE void _combine(V* out) noexcept {
+        constexpr size_t M = N / 4;
+        const auto& tw = TwiddleTable<N, Inverse, D>::values;
+        for (size_t k = 0; k < M; k++) {
+            V a = _twiddle<A, N, 0, Inverse, D>(out[k]);
+            V b = A::_cmulc(out[k + M], tw[6 * k], tw[6 * k + 1]);
+            V c = A::_cmulc(out[k + 2 * M], tw[6 * k + 2], tw[6 * k + 3]);
+            V d = A::_cmulc(out[k + 3 * M], tw[6 * k + 4], tw[6 * k + 5]);
+
+            V t0 = A::_cadd(a, c);
+            V t1 = A::_cadd(b, d);
+            V t2 = A::_csub(a, c);
+            V t3 = A::_cmulj(A::_csub(b, d));
+            out[k] = A::_cadd(t0, t1);
+            out[k + 2 * M] = A::_csub(t0, t1);
+            out[k + M] = Inverse ? A::_cadd(t2, t3) : A::_csub(t2, t3);
+            out[k + 3 * M] = Inverse ? A::_csub(t2, t3) : A::_cadd(t2, t3);
+        }
+    }
+
+    // Transforms the elements load(O), load(O + S), ..., load(O + (N - 1) * S) into out[0, N)
+    // in natural order, load being any callable from an index to a value, and divides them by D
+    template <typename A, size_t N, size_t S, size_t O, bool Inverse, size_t D = 1, typename V, typename Load>
+    FORCE_INLINE void _dit(V* out, const Load& load) noexcept {
+        static_assert((N & (N - 1)) == 0, "Codelets are only defined for powers of two");
+        if constexpr (N == 1) {
+            out[0] = _twiddle<A, 1, 0, Inverse, D>(load(O));
+        } else if constexpr (N == 2) {
+            V a = _twiddle<A, 2, 0, Inverse, D>(load(O));
+            V b = _twiddle<A, 2, 0, Inverse, D>(load(O + S));
+            out[0] = A::_cadd(a, b);
+            out[1] = A::_csub(a, b);
+        } else {
+            constexpr size_t M = N / 4;
+            _dit<A, M, 4 * S, O, Inverse>(out, load);
+            _dit<A, M, 4 * S, O + S, Inverse>(out + M, load);
+            _dit<A, M, 4 * S, O + 2 * S, Inverse>(out + 2 * M, load);
+            _dit<A, M, 4 * S, O + 3 * S, Inverse>(out + 3 * M, load);
+            if constexpr (N <= UNROLL_MAX) {
+                [&]<size_t... K>(std::index_sequence<K...>) __attribute__((always_inline)) {
+                    (_butterfly<A, N, K, Inverse, D>(out), ...);
+                }(std::make_index_sequence<M>{});
+            } else {
+                _combine<A, N, Inverse, D>(out);
+            }
+        }
+    }
+
+    // Small DFT kernels used by the mixed radix FFT, written against a backend A, a value
+    // type V (complex values or SIMD registers of them) and a real scalar type C
+    //
+    // Odd radices use the symmetric form of the DFT, with a_k = x_k + x_(R-k) and b_k = x_k - x_(R-k)
+    // c_j = x_0 + sum_k cos(2pi jk/R) * a_k
+    // d_j = sum_k sin(2pi jk/R) * b_k
+    // y_j = c_j - j * d_j, y_(R-j) = c_j + j * d_j (signs of j are flipped for the inverse)
+    //
+    // cs and sn hold cos(2pi jk/R) and sin(2pi jk/R) for j, k in [1, R/2], indexed by (j-1) * (R/2) + (k-1)
+    template <typename A, size_t R, bool Inverse, typename V, typename C>
+    FORCE_INLINE void radix_dft(V (&y)[R], const V (&x)[R], const C* cs, const C* sn) noexcept {
+        if constexpr (R == 2) {
+            y[0] = A::_cadd(x[0], x[1]);
+            y[1] = A::_csub(x[0], x[1]);
+        } else if constexpr (R == 4) {
+            V t0 = A::_cadd(x[0], x[2]);
+            V t1 = A::_cadd(x[1], x[3]);
+            V t2 = A::_csub(x[0], x[2]);
+            V t3 = A::_cmulj(A::_csub(x[1], x[3]));
+            y[0] = A::_cadd(t0, t1);
+            y[2] = A::_csub(t0, t1);
+            y[1] = Inverse ? A::_cadd(t2, t3) : A::_csub(t2, t3);
+            y[3] = Inverse ? A::_csub(t2, t3) : A::_cadd(t2, t3);
+        } else {
+            static_assert(R % 2 == 1, "Only radix 2, 4 and odd radices have kernels");
+            constexpr size_t H = R / 2;
+            V a[H], b[H];
+            y[0] = x[0];
+            for (size_t k = 1; k <= H; k++) {
+                a[k-1] = A::_cadd(x[k], x[R-k]);
+                b[k-1] = A::_csub(x[k], x[R-k]);
+                y[0] = A::_cadd(y[0], a[k-1]);
+            }
+            for (size_t j = 1; j <= H; j++) {
+                V c = A::_cfma(a[0], cs[(j-1) * H], x[0]);
+                V d = A::_cscale(b[0], sn[(j-1) * H]);
+                for (size_t k = 2; k <= H; k++) {
+                    c = A::_cfma(a[k-1], cs[(j-1) * H + k-1], c);
+                    d = A::_cfma(b[k-1], sn[(j-1) * H + k-1], d);
+                }
+                V jd = A::_cmulj(d);
+                y[j] = Inverse ? A::_cadd(c, jd) : A::_csub(c, jd);
+                y[R-j] = Inverse ? A::_csub(c, jd) : A::_cadd(c, jd);
+            }
+        }
+    }
+
+    // y = DFT(load(0), ..., load(N - 1)), the inverse when Inverse, divided by N when Normalized
+    // Reading the input through load lets the leaves pull their values straight from memory
+    template <typename A, size_t N, bool Inverse, bool Normalized = false, typename V, typename Load>
+    FORCE_INLINE void dft(V (&y)[N], const Load& load) noexcept {
+        _dit<A, N, 1, 0, Inverse, Normalized ? N : 1>(y, load);
+    }
+}
@@ -2,10 +2,9 @@
 
 #include <common.h>
 #include <arith/basearith.h>
+#include <arith/simd.h>
 
-#if __AVX2__
-#include <immintrin.h>
-#else
+#if !__AVX2__ && !SIMD_DISPATCH
 #pragma message("Compiling without AVX2 instructions")
 #endif
 
@@ -83,116 +82,129 @@ struct arith {
     }
 };
     
-#if __AVX2__
+#if __AVX2__ || SIMD_DISPATCH
 
-template<>
-struct arith<double> {
+// SIMD backend, written once for every register type S of simd.h
+template <typename S>
+struct simd_arith {
 
-    using BaseType = double;
-    using RegType = __m256d;
+    using BaseType = S::BaseType;
+    using RegType = S::Reg;
     static constexpr size_t Alignment = sizeof(RegType);
-    static constexpr size_t OpCapacity = (sizeof(RegType) / sizeof(BaseType));
-
-    static_assert(OpCapacity == 4, "Bad assumption with size of SIMD registers");
+    static constexpr size_t OpCapacity = S::Width;
 
     struct _add_op_t {
-        static inline void _exec(__m256d& c, const __m256d& a, const __m256d& b) noexcept {
-            c = _mm256_add_pd(a, b);
+        static FORCE_INLINE void _exec(RegType& c, const RegType& a, const RegType& b) noexcept {
+            c = S::add(a, b);
         }
     };
     struct _sub_op_t {
-        static inline void _exec(__m256d& c, const __m256d& a, const __m256d& b) noexcept {
-            c = _mm256_sub_pd(a, b);
+        static FORCE_INLINE void _exec(RegType& c, const RegType& a, const RegType& b) noexcept {
+            c = S::sub(a, b);
         }
     };
     struct _mul_op_t {
-        static inline void _exec(__m256d& c, const __m256d& a, const __m256d& b) noexcept {
-            c = _mm256_mul_pd(a, b);
+        static FORCE_INLINE void _exec(RegType& c, const RegType& a, const RegType& b) noexcept {
+            c = S::mul(a, b);
         }
     };
     struct _div_op_t {
-        static inline void _exec(__m256d& c, const __m256d& a, const __m256d& b) noexcept {
-            c = _mm256_div_pd(a, b);
+        static FORCE_INLINE void _exec(RegType& c, const RegType& a, const RegType& b) noexcept {
+            c = S::div(a, b);
         }
     };
 
     private:
     // Few notes:
-    // We will assume that all array sizes are divisible by 4
-    // This will be guaranteed by the vec class, which will provide 
-    // the necessary padding at the end of its array
+    // Whole registers use aligned loads, the start of every range must be aligned
+    // unless it is shorter than a register. The remainder of the range is 
+    // loaded and stored with a mask, so nothing past n is touched
     
-    template <typename Op, typename Intrin = __m256d> requires VecOp<Op, Intrin>
-    static inline void _vec_impl(double* c, const double* a, const double* b, size_t n, Op) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(a, b));
-        __m256d _a, _b, _c;
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            _a = _mm256_load_pd(&a[offset]); 
-            _b = _mm256_load_pd(&b[offset]);
-            Op::_exec(_c, _a, _b);
-            _mm256_store_pd(&c[offset], _c);
-        }     
-    }
-
-    template <typename Op, typename ...Args, typename Intrin = __m256d> requires VecOp<Op, Intrin>
-    static inline void _vec_impl(Op, size_t n, double* out, Args*... args) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(out, args...));
-        __m256d _out;
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            Op::_exec(_out, _mm256_load_pd(&args[offset])...);
-            _mm256_store_pd(&out[offset], _out);
-        }     
-    }
-
-    template<typename Op, typename Intrin = __m256d> requires VecOp<Op, Intrin>
-    static inline void _scalar_impl(Op, size_t n, double* c, const double* a, const double& b) noexcept {
-        ASSERT(autil::_assert_align<Alignment>(a));
-        __m256d _b = _mm256_broadcast_sd(&b);
-        for (uint32_t i = 0; i < autil::_num_loops<OpCapacity>(n); i++) {
-            uint32_t offset = OpCapacity * i;
-            __m256d _a = _mm256_load_pd(&a[offset]); 
-            __m256d _c; 
-            Op::_exec(_c, _a, _b);
-            _mm256_store_pd(&c[offset], _c);
-        }
+    template <typename Op, typename ...Args> requires VecOp<Op, RegType>
+    static FORCE_INLINE void _vec_impl(Op, size_t n, BaseType* out, Args*... args) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(out, args...));
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _out;
+            Op::_exec(_out, S::load(&args[offset], m)...);
+            S::store(&out[offset], _out, m);
+        });
+    }
+
+    template<typename Op> requires VecOp<Op, RegType>
+    static FORCE_INLINE void _scalar_impl(Op, size_t n, BaseType* c, const BaseType* a, const BaseType& b) noexcept {
+        ASSERT(n < OpCapacity || autil::_assert_align<Alignment>(c, a));
+        RegType _b = S::set1(b);
+        simd::for_each_reg<S>(n, [&](size_t offset, auto m) __attribute__((always_inline)) {
+            RegType _c; 
+            Op::_exec(_c, S::load(&a[offset], m), _b);
+            S::store(&c[offset], _c, m);
+        });
     }
 
     public:
-    static inline void _add_vec(double* c, const double* a, const double* b, size_t n) noexcept {
+    static inline SIMD_CLONES void _add_vec(BaseType* c, const BaseType* a, const BaseType* b, size_t n) noexcept {
         _vec_impl(_add_op_t{}, n, c, a, b);
     }
 
-    static inline void _sub_vec(double* c, const double* a, const double* b, size_t n) noexcept {
+    static inline SIMD_CLONES void _sub_vec(BaseType* c, const BaseType* a, const BaseType* b, size_t n) noexcept {
         _vec_impl(_sub_op_t{}, n, c, a, b);
     }
 
-    static inline void _mul_vec(double* c, const double* a, const double* b, size_t n) noexcept {
+    static inline SIMD_CLONES void _mul_vec(BaseType* c, const BaseType* a, const BaseType* b, size_t n) noexcept {
         _vec_impl(_mul_op_t{}, n, c, a, b);
     }
 
-    static inline void _div_vec(double* c, const double* a, const double* b, size_t n) noexcept {
+    static inline SIMD_CLONES void _div_vec(BaseType* c, const BaseType* a, const BaseType* b, size_t n) noexcept {
         _vec_impl(_div_op_t{}, n, c, a, b);
     }
 
-    static inline void _add_scalar(double* c, const double* a, const double& b, size_t n) noexcept {
+    static inline SIMD_CLONES void _add_scalar(BaseType* c, const BaseType* a, const BaseType& b, size_t n) noexcept {
         _scalar_impl(_add_op_t{}, n, c, a, b);
     }
 
-    static inline void _sub_scalar(double* c, const double* a, const double& b, size_t n) noexcept {
+    static inline SIMD_CLONES void _sub_scalar(BaseType* c, const BaseType* a, const BaseType& b, size_t n) noexcept {
         _scalar_impl(_sub_op_t{}, n, c, a, b);
     }
 
-    static inline void _mul_scalar(double* c, const double* a, const double& b, size_t n) noexcept {
+    static inline SIMD_CLONES void _mul_scalar(BaseType* c, const BaseType* a, const BaseType& b, size_t n) noexcept {
         _scalar_impl(_mul_op_t{}, n, c, a, b);
     }
 
-    static inline void _div_scalar(double* c, const double* a, const double& b, size_t n) noexcept {
+    static inline SIMD_CLONES void _div_scalar(BaseType* c, const BaseType* a, const BaseType& b, size_t n) noexcept {
         _scalar_impl(_div_op_t{}, n, c, a, b);
     }
 
 };
+
+#if __AVX512F__
+template<>
+struct arith<double> : simd_arith<simd::avx512<double>> {
+    static_assert(OpCapacity == 8, "Bad assumption with size of SIMD registers");
+};
+
+template<>
+struct arith<float> : simd_arith<simd::avx512<float>> {
+    static_assert(OpCapacity == 16, "Bad assumption with size of SIMD registers");
+};
+#elif __AVX2__
+template<>
+struct arith<double> : simd_arith<simd::avx2<double>> {
+    static_assert(OpCapacity == 4, "Bad assumption with size of SIMD registers");
+};
+
+template<>
+struct arith<float> : simd_arith<simd::avx2<float>> {
+    static_assert(OpCapacity == 8, "Bad assumption with size of SIMD registers");
+};
+#else
+template<>
+struct arith<double> : simd_arith<simd::vext<double>> {
+};
+
+template<>
+struct arith<float> : simd_arith<simd::vext<float>> {
+};
+#endif
 #endif 
 
 using farith = arith<float>;
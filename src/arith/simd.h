@@ -0,0 +1,280 @@
+#pragma once
+
+#include <common.h>
+
+#if __AVX2__
+#include <immintrin.h>
+#endif
+
+// Thin wrappers over the intrinsics of a single register type
+//
+// The SIMD backends of arith and carith are written once against these, so that
+// every floating point type shares the same kernels and only differs in the
+// width of its registers.
+//
+// Loads and stores come in two flavours: with full_t, the pointer must be aligned
+// and the whole register is used, with a Mask only the first lanes are touched
+// and the pointer may be unaligned, which handles the tail of a range.
+//
+// Builds with SIMD_DISPATCH and without a -m flag use the vext registers instead,
+// and every entry point of the backends marked SIMD_CLONES is compiled once per
+// instruction set. The loader picks the best one for the CPU through CPUID.
+namespace simd {
+
+    struct full_t {};
+    inline constexpr full_t full{};
+
+#if __AVX2__
+    template <typename T>
+    struct avx2;
+
+    template <typename T>
+    struct avx512;
+
+    template <>
+    struct avx2<double> {
+        using BaseType = double;
+        using Reg = __m256d;
+        using Mask = __m256i;
+        static constexpr size_t Width = sizeof(Reg) / sizeof(BaseType);
+
+        // The first n lanes
+        static FORCE_INLINE Mask mask(size_t n) noexcept {
+            return _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_setr_epi64x(0, 1, 2, 3));
+        }
+
+        static FORCE_INLINE Reg load(const double* p, full_t = full) noexcept {
+            return _mm256_load_pd(p);
+        }
+
+        static FORCE_INLINE Reg load(const double* p, Mask m) noexcept {
+            return _mm256_maskload_pd(p, m);
+        }
+
+        static FORCE_INLINE void store(double* p, Reg a, full_t = full) noexcept {
+            _mm256_store_pd(p, a);
+        }
+
+        static FORCE_INLINE void store(double* p, Reg a, Mask m) noexcept {
+            _mm256_maskstore_pd(p, m, a);
+        }
+
+        static FORCE_INLINE Reg set1(double a) noexcept { return _mm256_set1_pd(a); }
+        static FORCE_INLINE Reg zero() noexcept { return _mm256_setzero_pd(); }
+        static FORCE_INLINE Reg add(Reg a, Reg b) noexcept { return _mm256_add_pd(a, b); }
+        static FORCE_INLINE Reg sub(Reg a, Reg b) noexcept { return _mm256_sub_pd(a, b); }
+        static FORCE_INLINE Reg mul(Reg a, Reg b) noexcept { return _mm256_mul_pd(a, b); }
+        static FORCE_INLINE Reg div(Reg a, Reg b) noexcept { return _mm256_div_pd(a, b); }
+        // a * b + c
+        static FORCE_INLINE Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+        // a * b - c
+        static FORCE_INLINE Reg fmsub(Reg a, Reg b, Reg c) noexcept { return _mm256_fmsub_pd(a, b, c); }
+    };
+
+    template <>
+    struct avx2<float> {
+        using BaseType = float;
+        using Reg = __m256;
+        using Mask = __m256i;
+        static constexpr size_t Width = sizeof(Reg) / sizeof(BaseType);
+
+        static FORCE_INLINE Mask mask(size_t n) noexcept {
+            return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        }
+
+        static FORCE_INLINE Reg load(const float* p, full_t = full) noexcept {
+            return _mm256_load_ps(p);
+        }
+
+        static FORCE_INLINE Reg load(const float* p, Mask m) noexcept {
+            return _mm256_maskload_ps(p, m);
+        }
+
+        static FORCE_INLINE void store(float* p, Reg a, full_t = full) noexcept {
+            _mm256_store_ps(p, a);
+        }
+
+        static FORCE_INLINE void store(float* p, Reg a, Mask m) noexcept {
+            _mm256_maskstore_ps(p, m, a);
+        }
+
+        static FORCE_INLINE Reg set1(float a) noexcept { return _mm256_set1_ps(a); }
+        static FORCE_INLINE Reg zero() noexcept { return _mm256_setzero_ps(); }
+        static FORCE_INLINE Reg add(Reg a, Reg b) noexcept { return _mm256_add_ps(a, b); }
+        static FORCE_INLINE Reg sub(Reg a, Reg b) noexcept { return _mm256_sub_ps(a, b); }
+        static FORCE_INLINE Reg mul(Reg a, Reg b) noexcept { return _mm256_mul_ps(a, b); }
+        static FORCE_INLINE Reg div(Reg a, Reg b) noexcept { return _mm256_div_ps(a, b); }
+        static FORCE_INLINE Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+        static FORCE_INLINE Reg fmsub(Reg a, Reg b, Reg c) noexcept { return _mm256_fmsub_ps(a, b, c); }
+    };
+
+#if __AVX512F__
+    // Masks are native on AVX-512, a masked load never faults on the lanes it skips
+    template <>
+    struct avx512<double> {
+        using BaseType = double;
+        using Reg = __m512d;
+        using Mask = __mmask8;
+        static constexpr size_t Width = sizeof(Reg) / sizeof(BaseType);
+
+        static FORCE_INLINE Mask mask(size_t n) noexcept {
+            return static_cast<Mask>((1u << n) - 1);
+        }
+
+        static FORCE_INLINE Reg load(const double* p, full_t = full) noexcept {
+            return _mm512_load_pd(p);
+        }
+
+        static FORCE_INLINE Reg load(const double* p, Mask m) noexcept {
+            return _mm512_maskz_loadu_pd(m, p);
+        }
+
+        static FORCE_INLINE void store(double* p, Reg a, full_t = full) noexcept {
+            _mm512_store_pd(p, a);
+        }
+
+        static FORCE_INLINE void store(double* p, Reg a, Mask m) noexcept {
+            _mm512_mask_storeu_pd(p, m, a);
+        }
+
+        static FORCE_INLINE Reg set1(double a) noexcept { return _mm512_set1_pd(a); }
+        static FORCE_INLINE Reg zero() noexcept { return _mm512_setzero_pd(); }
+        static FORCE_INLINE Reg add(Reg a, Reg b) noexcept { return _mm512_add_pd(a, b); }
+        static FORCE_INLINE Reg sub(Reg a, Reg b) noexcept { return _mm512_sub_pd(a, b); }
+        static FORCE_INLINE Reg mul(Reg a, Reg b) noexcept { return _mm512_mul_pd(a, b); }
+        static FORCE_INLINE Reg div(Reg a, Reg b) noexcept { return _mm512_div_pd(a, b); }
+        static FORCE_INLINE Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+        static FORCE_INLINE Reg fmsub(Reg a, Reg b, Reg c) noexcept { return _mm512_fmsub_pd(a, b, c); }
+    };
+
+    template <>
+    struct avx512<float> {
+        using BaseType = float;
+        using Reg = __m512;
+        using Mask = __mmask16;
+        static constexpr size_t Width = sizeof(Reg) / sizeof(BaseType);
+
+        static FORCE_INLINE Mask mask(size_t n) noexcept {
+            return static_cast<Mask>((1u << n) - 1);
+        }
+
+        static FORCE_INLINE Reg load(const float* p, full_t = full) noexcept {
+            return _mm512_load_ps(p);
+        }
+
+        static FORCE_INLINE Reg load(const float* p, Mask m) noexcept {
+            return _mm512_maskz_loadu_ps(m, p);
+        }
+
+        static FORCE_INLINE void store(float* p, Reg a, full_t = full) noexcept {
+            _mm512_store_ps(p, a);
+        }
+
+        static FORCE_INLINE void store(float* p, Reg a, Mask m) noexcept {
+            _mm512_mask_storeu_ps(p, m, a);
+        }
+
+        static FORCE_INLINE Reg set1(float a) noexcept { return _mm512_set1_ps(a); }
+        static FORCE_INLINE Reg zero() noexcept { return _mm512_setzero_ps(); }
+        static FORCE_INLINE Reg add(Reg a, Reg b) noexcept { return _mm512_add_ps(a, b); }
+        static FORCE_INLINE Reg sub(Reg a, Reg b) noexcept { return _mm512_sub_ps(a, b); }
+        static FORCE_INLINE Reg mul(Reg a, Reg b) noexcept { return _mm512_mul_ps(a, b); }
+        static FORCE_INLINE Reg div(Reg a, Reg b) noexcept { return _mm512_div_ps(a, b); }
+        static FORCE_INLINE Reg fmadd(Reg a, Reg b, Reg c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+        static FORCE_INLINE Reg fmsub(Reg a, Reg b, Reg c) noexcept { return _mm512_fmsub_ps(a, b, c); }
+    };
+#endif
+#endif
+
+#if SIMD_DISPATCH && !__AVX2__
+// Default (SSE2), AVX + FMA and AVX-512 versions of every entry point
+// Features rather than "arch=" names, the latter only match one exact CPU model
+#define SIMD_CLONES __attribute__((target_clones("default", "fma", "avx512f")))
+
+    // Registers of a fixed 64 bytes written with the vector extensions of GCC and clang
+    //
+    // The same code is lowered to one zmm register per op in the avx512f clone, two ymm
+    // registers in the fma clone and four xmm registers in the default one. The layout
+    // of the data (alignment and padding) is therefore the same whatever CPU runs it.
+    // FMA instructions come from contracting a * b + c, the default for GNU C++.
+    template <typename T>
+    struct vext {
+        using BaseType = T;
+        typedef T Reg __attribute__((vector_size(64)));
+        // Number of lanes
+        using Mask = size_t;
+        static constexpr size_t Width = sizeof(Reg) / sizeof(BaseType);
+
+        static FORCE_INLINE Mask mask(size_t n) noexcept {
+            return n;
+        }
+
+        static FORCE_INLINE Reg load(const T* p, full_t = full) noexcept {
+            Reg a;
+            __builtin_memcpy(&a, p, sizeof(Reg));
+            return a;
+        }
+
+        // Whole registers need no alignment here, which the unaligned callers of a full mask rely on
+        static FORCE_INLINE Reg load(const T* p, Mask m) noexcept {
+            if (m == Width) {
+                return load(p);
+            }
+            Reg a = zero();
+            for (size_t i = 0; i < m; i++) {
+                a[i] = p[i];
+            }
+            return a;
+        }
+
+        // Lane by lane, GCC otherwise bounces registers wider than the target through the stack
+        static FORCE_INLINE void store(T* p, Reg a, full_t = full) noexcept {
+            for (size_t i = 0; i < Width; i++) {
+                p[i] = a[i];
+            }
+        }
+
+        static FORCE_INLINE void store(T* p, Reg a, Mask m) noexcept {
+            if (m == Width) {
+                return store(p, a);
+            }
+            for (size_t i = 0; i < m; i++) {
+                p[i] = a[i];
+            }
+        }
+
+        static FORCE_INLINE Reg set1(T a) noexcept { return Reg{} + a; }
+        static FORCE_INLINE Reg zero() noexcept { return Reg{}; }
+        static FORCE_INLINE Reg add(Reg a, Reg b) noexcept { return a + b; }
+        static FORCE_INLINE Reg sub(Reg a, Reg b) noexcept { return a - b; }
+        static FORCE_INLINE Reg mul(Reg a, Reg b) noexcept { return a * b; }
+        static FORCE_INLINE Reg div(Reg a, Reg b) noexcept { return a / b; }
+        static FORCE_INLINE Reg fmadd(Reg a, Reg b, Reg c) noexcept { return a * b + c; }
+        static FORCE_INLINE Reg fmsub(Reg a, Reg b, Reg c) noexcept { return a * b - c; }
+    };
+
+    // The clone the loader picked on this machine, for logging
+    inline const char* dispatch_target() noexcept {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return "avx512f";
+        if (__builtin_cpu_supports("fma")) return "fma";
+        return "default";
+    }
+#else
+#define SIMD_CLONES
+#endif
+
+    // Runs body(offset, m) over the registers covering [0, n), where m is full for
+    // the whole registers and a Mask of the remaining lanes for the last one
+    template <typename S, typename F>
+    FORCE_INLINE void for_each_reg(size_t n, F&& body) {
+        size_t nvec = n / S::Width;
+        for (size_t i = 0; i < nvec; i++) {
+            body(S::Width * i, full);
+        }
+        if (n % S::Width != 0) {
+            body(S::Width * nvec, S::mask(n % S::Width));
+        }
+    }
+}
+
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "operation.h"
+#include "tview.h"
+#include <common.h>
+#include <fft.h>
+#include <fixedfft.h>
+#include <shuffler.h>
+#include <twiddle.h>
+#include <algorithm>
+#include <memory>
+
+// Many transforms of the same power of two size at once
+//
+// Small transforms are too short to fill SIMD registers for long within a
+// single signal, so BatchFFT instead runs LANES signals side by side: the 
+// signals are interleaved into a [n][LANES] workspace, with the bit reversal
+// folded into that gather, and every butterfly then works on LANES
+// independent signals with the same broadcast twiddle factor.
+//
+// Sizes from 8 to FixedFFT::MAX_SIZE skip the layers entirely and run a
+// straight line codelet on the group, which reads the signals in natural order.
+//
+// Transforms above VERTICAL_MAX no longer fit the workspace in cache and are
+// run one after the other through a single FFT object instead, which is only
+// built for those sizes.
+template <typename T> requires ScalarType<T>
+class BatchFFT {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+
+    // Signals per group, at least 256 bits worth (4 doubles or 8 floats) and one full register
+    // Wider groups were measured slower with AVX2, the workspace falls out of L1 sooner
+    static constexpr size_t LANES = std::max<size_t>(32 / sizeof(T), Arith<AlgType>::OpCapacity);
+    static constexpr size_t VERTICAL_MAX = 1024;
+
+    private:
+    size_t _size;
+    std::unique_ptr<FFT<T>> single; // Above VERTICAL_MAX only
+    const TwiddleStore<T> twiddles;
+    std::vector<uint32_t> rev; // Gather order, the bit reversal of [0, n) unless a codelet is used
+    mutable Vec<AlgType> work; // n * LANES elements
+
+    // Block i of the workspace, element i of every signal in the group
+    inline MutView<AlgType> _lanes(size_t i) const noexcept {
+        return MutView<AlgType>(work.data_ptr() + i * LANES, LANES);
+    }
+
+    // First layer when log2(n) is odd, all twiddle factors are 1
+    void _layer_2() const noexcept {
+        AlgType one{1.0, 0.0};
+        for (size_t b = 0; b < _size; b += 2) {
+            auto x = _lanes(b);
+            auto y = _lanes(b + 1);
+            altAddSubMultScalar(x, y, x, y, one);
+        }
+    }
+
+    // Radix-4 layer of size m, with the quarters in bit reversed order as in FFT
+    void _quad_layer(size_t m) const noexcept {
+        size_t q = m / 4;
+        auto w1 = twiddles.get_layer(m);
+        auto w2 = twiddles.get_layer(m / 2);
+        auto w3 = twiddles.get_cube_layer(m);
+        for (size_t b = 0; b < _size; b += m) {
+            for (size_t j = 0; j < q; j++) {
+                auto x0 = _lanes(b + j);
+                auto x1 = _lanes(b + j + q);
+                auto x2 = _lanes(b + j + 2 * q);
+                auto x3 = _lanes(b + j + 3 * q);
+                quadAddSubProdScalar(x0, x1, x2, x3, w1[j], w2[j], w3[j]);
+            }
+        }
+    }
+
+    inline static bool _has_codelet(size_t n) noexcept {
+        return n >= 8 && n <= FixedFFT<T, 8>::MAX_SIZE;
+    }
+
+    // Forward transform of the whole group in the workspace
+    void _transform() const noexcept {
+        using tarith = carith<AlgType>;
+        switch (_size) {
+            case 8: return tarith::template _fcodelet<8, false>(work.data_ptr(), LANES, LANES);
+            case 16: return tarith::template _fcodelet<16, false>(work.data_ptr(), LANES, LANES);
+            case 32: return tarith::template _fcodelet<32, false>(work.data_ptr(), LANES, LANES);
+            case 64: return tarith::template _fcodelet<64, false>(work.data_ptr(), LANES, LANES);
+        }
+
+        size_t m = 4;
+        if (shuffle::num_bits(_size) % 2 == 1) {
+            _layer_2();
+            m = 8;
+        }
+        for (; m <= _size; m *= 4) {
+            _quad_layer(m);
+        }
+    }
+
+    // Transforms count <= LANES signals starting at data, each stride apart
+    void _group_impl(complexptr<T> data, size_t stride, size_t count, bool inverse) const noexcept {
+        BaseType* re = work.rdata();
+        BaseType* im = work.idata();
+
+        // Gather in the order the transform expects, unused lanes are zeroed
+        // The inverse is computed as conj(DFT(conj(x))) / n
+        BaseType sign = inverse ? -1.0 : 1.0;
+        for (size_t i = 0; i < _size; i++) {
+            size_t dst = rev[i] * LANES;
+            for (size_t l = 0; l < count; l++) {
+                re[dst + l] = data.re[l * stride + i];
+                im[dst + l] = sign * data.im[l * stride + i];
+            }
+            for (size_t l = count; l < LANES; l++) {
+                re[dst + l] = 0.0;
+                im[dst + l] = 0.0;
+            }
+        }
+
+        _transform();
+
+        BaseType scale = inverse ? 1.0 / (1.0 * _size) : 1.0;
+        for (size_t i = 0; i < _size; i++) {
+            for (size_t l = 0; l < count; l++) {
+                data.re[l * stride + i] = scale * re[i * LANES + l];
+                data.im[l * stride + i] = sign * scale * im[i * LANES + l];
+            }
+        }
+    }
+
+    void _batch_impl(MutView<AlgType>& data, size_t count, bool inverse) const {
+        // A single point is its own transform
+        if (_size == 1) return;
+
+        if (_size > VERTICAL_MAX) {
+            for (size_t s = 0; s < count; s++) {
+                MutView<AlgType> row(data.data() + s * _size, _size);
+                if (inverse) {
+                    single->ifft(row);
+                } else {
+                    single->fft(row);
+                }
+            }
+            return;
+        }
+
+        for (size_t s = 0; s < count; s += LANES) {
+            _group_impl(data.data() + s * _size, _size, std::min(LANES, count - s), inverse);
+        }
+    }
+
+    public:
+    // n is the size of every transform, and must be a power of two
+    BatchFFT(size_t n) : _size(n), twiddles(n), rev(n), 
+        work{(n <= VERTICAL_MAX) ? n * LANES : 1} {
+        ASSERT(util::is_pow2(n));
+        if (n > VERTICAL_MAX) {
+            single = std::make_unique<FFT<T>>(n);
+        }
+        size_t bits = shuffle::num_bits(n);
+        for (size_t i = 0; i < n; i++) {
+            rev[i] = (n > 1 && !_has_codelet(n)) ? shuffle::rev_int(i, bits) : i;
+        }
+    }
+
+    // Transforms count signals of size() elements stored back to back in data
+    MutView<AlgType> fft(MutView<AlgType> data, size_t count) const {
+        ASSERT(data.size() >= count * _size);
+        _batch_impl(data, count, false);
+        return data;
+    }
+
+    MutView<AlgType> ifft(MutView<AlgType> data, size_t count) const {
+        ASSERT(data.size() >= count * _size);
+        _batch_impl(data, count, true);
+        return data;
+    }
+
+    // Transforms every row of a two dimensional Vec{rows, size()}
+    // Rows added as alignment padding of the first dimension are transformed as well
+    void fft(Vec<AlgType>& batch) const {
+        ASSERT(batch.ndim() == 3 && batch.stride() == _size);
+        MutView<AlgType> data(batch);
+        fft(data, batch.size() / _size);
+    }
+
+    void ifft(Vec<AlgType>& batch) const {
+        ASSERT(batch.ndim() == 3 && batch.stride() == _size);
+        MutView<AlgType> data(batch);
+        ifft(data, batch.size() / _size);
+    }
+
+    inline size_t size() const noexcept {
+        return _size;
+    }
+};
+
+template class BatchFFT<double>;
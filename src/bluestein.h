@@ -0,0 +1,253 @@
+#pragma once
+
+#include "operation.h"
+#include "tview.h"
+#include <common.h>
+#include <function.h>
+#include <fft.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numbers>
+
+// The chirps and kernel spectra of the Bluestein transforms of size N, in both directions
+//
+// Using nk = (n^2 + k^2 - (k - n)^2) / 2, the DFT can be rewritten as
+//
+//     X_k = w_k * sum_n (x_n * w_n) * w*_(k-n),   w_n = exp(-j * pi * n^2 / N)
+//
+// Which is a convolution of the chirped input with the conjugate chirp. The inverse is
+// the same with every chirp conjugated, x_n = w*_n * sum_k (X_k * w*_k) * w_(n-k) / N
+// The convolution is done circularly over a power of two M >= 2N - 1
+//
+// The kernels are kept in the form FFT::convolve takes, and the 1/N of the inverse
+// is folded into its kernel, so neither direction makes a pass of its own for it
+// A table is filled by its constructor and never modified afterwards
+template <typename T> requires ScalarType<T>
+class BluesteinTable {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    static constexpr BaseType PI = std::numbers::pi_v<BaseType>;
+
+    private:
+    size_t _size;
+    size_t _conv_size;
+    Vec<AlgType> _chirp; // w_n
+    Vec<AlgType> _conj_chirp; // w*_n
+    Vec<AlgType> _kernel; // Spectrum of w*_n
+    Vec<AlgType> _conj_kernel; // Spectrum of w_n, divided by N
+
+    static Vec<AlgType> make_chirp(size_t N, BaseType sign) {
+        Vec<AlgType> c{N};
+        for (size_t n = 0; n < N; n++) {
+            // n^2 mod 2N keeps the angle small for large n
+            BaseType angle = -PI * (1.0 * ((n * n) % (2 * N))) / (1.0 * N);
+            c.rdata()[n] = std::cos(angle);
+            c.idata()[n] = sign * std::sin(angle);
+        }
+        return c;
+    }
+
+    // The conjugate of chirp for n in (-N, N), wrapped around the circular convolution
+    // and turned into the form convolve() takes
+    static Vec<AlgType> make_kernel(const Vec<AlgType>& chirp, size_t N, size_t M, BaseType scale) {
+        Vec<AlgType> k{M};
+        k.zero();
+        for (size_t n = 0; n < N; n++) {
+            k.rdata()[n] = scale * chirp.rdata()[n];
+            k.idata()[n] = -scale * chirp.idata()[n];
+            if (n != 0) {
+                k.rdata()[M - n] = scale * chirp.rdata()[n];
+                k.idata()[M - n] = -scale * chirp.idata()[n];
+            }
+        }
+        FFT<T>(M).convolution_kernel(k);
+        return k;
+    }
+
+    public:
+    BluesteinTable(size_t N) : 
+        _size(N), _conv_size(conv_size(N)), _chirp(make_chirp(N, 1.0)), _conj_chirp(make_chirp(N, -1.0)),
+        _kernel(make_kernel(_chirp, N, _conv_size, 1.0)), 
+        _conj_kernel(make_kernel(_conj_chirp, N, _conv_size, 1.0 / (1.0 * N))) {
+        ASSERT(N >= 1);
+    }
+
+    BluesteinTable(const BluesteinTable&) = delete;
+    BluesteinTable& operator=(const BluesteinTable&) = delete;
+
+    static size_t conv_size(size_t N) {
+        return util::fft_size<Arith<AlgType>::OpCapacity>(2 * N - 1);
+    }
+
+    inline size_t size() const noexcept {
+        return _size;
+    }
+
+    inline size_t conv_size() const noexcept {
+        return _conv_size;
+    }
+
+    // w_n for the forward transform, w*_n for the inverse
+    ConstView<AlgType> chirp(bool forward) const {
+        return ConstView<AlgType>(forward ? _chirp : _conj_chirp);
+    }
+
+    ConstView<AlgType> kernel(bool forward) const {
+        return ConstView<AlgType>(forward ? _kernel : _conj_kernel);
+    }
+};
+
+// Process wide Bluestein tables, one per size and precision
+//
+// The first request of a size builds its table, the others share it. Tables up to
+// KEPT_MAX are kept until clear(), which bounds what the registry itself holds.
+// Larger ones are only referenced weakly and freed with the last transform using them,
+// as the large twiddle tables are (see TwiddleRegistry)
+//
+// A table is built outside the lock, so that sizes requested by different threads
+// are built at the same time. Two threads racing on the same new size may both
+// build it, the one that publishes last adopts the table of the other
+template <typename T> requires ScalarType<T>
+class BluesteinRegistry {
+    using Table = BluesteinTable<T>;
+
+    static std::map<size_t, std::shared_ptr<const Table>> kept;
+    static std::map<size_t, std::weak_ptr<const Table>> shared;
+    static std::mutex lock;
+
+    static std::shared_ptr<const Table> _find(size_t N) {
+        if (N <= KEPT_MAX) {
+            auto it = kept.find(N);
+            return it == kept.end() ? nullptr : it->second;
+        }
+        auto it = shared.find(N);
+        return it == shared.end() ? nullptr : it->second.lock();
+    }
+
+    public:
+    // Largest size whose table outlives its transforms, about 10 * N complex values each
+    static constexpr size_t KEPT_MAX = 1024;
+
+    static std::shared_ptr<const Table> get(size_t N) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (auto table = _find(N)) {
+                return table;
+            }
+        }
+
+        auto built = std::make_shared<const Table>(N);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (auto table = _find(N)) {
+            return table;
+        }
+        if (N <= KEPT_MAX) {
+            kept[N] = built;
+        } else {
+            // Drops the entries of the tables freed since, so the map does not grow either
+            std::erase_if(shared, [](const auto& entry) { return entry.second.expired(); });
+            shared[N] = built;
+        }
+        return built;
+    }
+
+    // Drops the registry's tables, each is freed once the last BluesteinFFT using it is
+    static void clear() {
+        std::lock_guard<std::mutex> guard(lock);
+        kept.clear();
+        shared.clear();
+    }
+};
+
+template <typename T> requires ScalarType<T>
+std::map<size_t, std::shared_ptr<const BluesteinTable<T>>> BluesteinRegistry<T>::kept;
+
+template <typename T> requires ScalarType<T>
+std::map<size_t, std::weak_ptr<const BluesteinTable<T>>> BluesteinRegistry<T>::shared;
+
+template <typename T> requires ScalarType<T>
+std::mutex BluesteinRegistry<T>::lock;
+
+// FFT for arbitrary sizes through Bluestein's chirp-z algorithm, see BluesteinTable
+// The chirps and kernel spectra come from the BluesteinRegistry, so the objects
+// of the same size share them
+//
+// The convolution runs in an internal workspace of M elements
+template <typename T> requires ScalarType<T>
+class BluesteinFFT : public BaseFunction<complex<T>> {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+
+    bool forward = true;
+
+    private:
+    std::shared_ptr<const BluesteinTable<T>> table;
+    FFT<T> conv;
+    mutable Vec<AlgType> work;
+
+    // X_k = c_k * (a * k)_k with a_n = x_n * c_n, the chirp c and kernel k of the direction
+    void _fft_impl(MutView<AlgType>& data, bool fwd) const {
+        size_t N = size();
+        MutView<AlgType> wview(work);
+        MutView<AlgType> head(work.data_ptr(), N);
+        ConstView<AlgType> cview = table->chirp(fwd);
+
+        // a_n = x_n * c_n, zero padded to M
+        std::memcpy(work.rdata(), data.data().re, sizeof(BaseType) * N);
+        std::memcpy(work.idata(), data.data().im, sizeof(BaseType) * N);
+        head *= cview;
+        std::fill(work.rdata() + N, work.rdata() + work.size(), BaseType(0.0));
+        std::fill(work.idata() + N, work.idata() + work.size(), BaseType(0.0));
+
+        conv.convolve(wview, table->kernel(fwd));
+
+        head *= cview;
+        std::memcpy(data.data().re, work.rdata(), sizeof(BaseType) * N);
+        std::memcpy(data.data().im, work.idata(), sizeof(BaseType) * N);
+    }
+
+    public:
+    BluesteinFFT(size_t N, bool forward = true) : 
+        forward(forward), table(BluesteinRegistry<T>::get(N)), 
+        conv(table->conv_size()), work{table->conv_size()} {
+        ASSERT(N >= 1);
+    }
+
+    MutView<AlgType> fft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), size());
+        _fft_impl(data, true);
+
+        return input;
+    }
+
+    MutView<AlgType> ifft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), size());
+        _fft_impl(data, false);
+
+        return input;
+    }
+
+    MutView<AlgType> operator()(MutView<AlgType> input) const override {
+        if (forward) return fft(std::move(input));
+        else return ifft(std::move(input));
+    }
+
+    size_t input_size() const override {
+        return 1;
+    }
+
+    inline size_t size() const noexcept {
+        return table->size();
+    }
+};
+
+template class BluesteinFFT<double>;
@@ -23,6 +23,13 @@
 
 #endif
 
+// For straight line kernels whose benefit depends on collapsing into a single body
+#if defined(__GNUC__) || defined(__clang__)
+#define FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define FORCE_INLINE inline
+#endif
+
 template<typename T>
 concept ScalarType = std::is_scalar_v<T>;
 
@@ -65,9 +72,24 @@ namespace util {
         return ((size - 1) / ALIGNMENT + 1) * ALIGNMENT;
     }
 
+    // Smallest power of two transform size holding n elements
+    // The FFT works on the whole Vec, so it is at least one SIMD register of
+    // CAPACITY elements long, and at least 4 for the radix-4 layers
+    // 3 capacity 4 -> 4
+    // 9 capacity 4 -> 16
+    // 1 capacity 8 -> 8
+    template<size_t CAPACITY>
+    constexpr size_t fft_size(size_t n) noexcept {
+        size_t size = (CAPACITY > 4) ? CAPACITY : 4;
+        while (size < n) {
+            size *= 2;
+        }
+        return size;
+    }
+
     template<typename T>
     constexpr bool is_pow2(T a) noexcept {
-        return (a != 0) && ((a & (a >> 1)) == 0);
+        return (a != 0) && ((a & (a - 1)) == 0);
     }
 
     constexpr uint64_t pow2(uint64_t a) noexcept {
@@ -171,6 +171,7 @@ struct complexptr {
     using RefType = complexref<BaseType>;
     T* re;
     T* im;
+    complexptr() : re(nullptr), im(nullptr) {}
     complexptr(T* re, T* im) : re(re), im(im) {}
 
     // Constructor required for complexptr(nullptr) to evaluate correctly
@@ -206,6 +207,7 @@ struct ccomplexptr {
     using BaseType = T;
     const T* re;
     const T* im;
+    ccomplexptr() : re(nullptr), im(nullptr) {}
     ccomplexptr(const T* re, const T* im) : re(re), im(im) {}
 
     ccomplexptr(const complexptr<T> orig) : re(orig.re), im(orig.im){}
@@ -2,6 +2,8 @@
 
 #include <function.h>
 #include <fft.h>
+#include <algorithm>
+#include <cstring>
 
 // Although convolution does not require only complex types
 // our FFT algorithm only supports complex values, therefore
@@ -18,11 +20,10 @@ class ConvolutionFunction : public BaseFunction<T> {
         dft_kernel();
     }
 
+    // The kernel is kept in the bit reversed order the transforms work in, 
+    // so neither direction needs its bit reversal (see FFT::convolve)
     MutView<T> operator()(MutView<T> input) const override {
-        input = fft.fft(input);
-        input *= kview;
-        input = fft.ifft(input);
-        return input; // So easy
+        return fft.convolve(input, ConstView<T>(kernel)); // So easy
     }
 
     constexpr size_t input_size() const override {
@@ -30,6 +31,275 @@ class ConvolutionFunction : public BaseFunction<T> {
     }
 
     void dft_kernel() {
-        fft.fft(kview);
+        fft.convolution_kernel(kview);
     }
 };
+
+// Part of the linear convolution of L inputs with M kernel samples 
+// to output, the same as numpy.convolve
+// Full: every partial overlap, L + M - 1 samples
+// Same: the centre max(L, M) samples of Full
+// Valid: the complete overlaps only, max(L, M) - min(L, M) + 1 samples
+enum class ConvMode {
+    Full,
+    Same,
+    Valid
+};
+
+// Linear convolution of inputs of any length with a kernel of any length
+//
+// Inputs are cut into blocks by overlap-save: each block of N samples is convolved
+// circularly with the kernel zero padded to N, and the N - M + 1 outputs that did not
+// wrap around are kept. The next block starts M - 1 samples before the end of this one
+// N is picked on construction as the power of two doing the least work per output, 
+// or, given the length of the inputs to come, the least work for all of it, which is 
+// a single block when both are short. The padded kernel spectrum is computed once
+//
+// The blocks run in an internal workspace of N elements
+template <typename T> requires ComplexType<T>
+class LinearConvolution {
+
+    public:
+    using AlgType = T;
+
+    // Fixed cost of a block (copies, calls) on top of the N log2(N) of its transforms
+    static constexpr size_t BLOCK_OVERHEAD = 4096;
+
+    private:
+    size_t _kernel_size;
+    size_t _block_size;
+    ConvolutionFunction<T> conv; // Holds the spectrum of the padded kernel
+    mutable Vec<T> work;
+
+    // Work of the blocks of size n producing out samples, or a single one when out = 0
+    static double cost(size_t n, size_t M, size_t out) noexcept {
+        double step = 1.0 * (n - M + 1);
+        double blocks = (out == 0) ? 1.0 / step : std::ceil(out / step);
+        return blocks * (1.0 * n * shuffle::num_bits(n) + BLOCK_OVERHEAD);
+    }
+
+    // Index of the first sample of mode in the full convolution
+    static size_t first(size_t L, size_t M, ConvMode mode) noexcept {
+        switch (mode) {
+            case ConvMode::Same: return (std::min(L, M) - 1) / 2;
+            case ConvMode::Valid: return std::min(L, M) - 1;
+            default: return 0;
+        }
+    }
+
+    public:
+    // input_size is the length of the inputs to come, 0 when unknown or varying
+    LinearConvolution(ConstView<T> kernel, size_t input_size = 0) : 
+        _kernel_size(kernel.size()), _block_size(block_size(kernel.size(), input_size)),
+        conv(make_kernel(kernel, _block_size)), work{_block_size} {
+        ASSERT(kernel.size() >= 1);
+    }
+
+    // The kernel zero padded to N
+    static Vec<T> make_kernel(const ConstView<T>& kernel, size_t N) {
+        Vec<T> k{N};
+        k.zero();
+        std::memcpy(k.rdata(), kernel.data().re, sizeof(typename T::BaseType) * kernel.size());
+        std::memcpy(k.idata(), kernel.data().im, sizeof(typename T::BaseType) * kernel.size());
+        return k;
+    }
+
+    // Block size for a kernel of M samples, see the class comment
+    static size_t block_size(size_t M, size_t input_size = 0) noexcept {
+        size_t n = util::fft_size<Arith<T>::OpCapacity>(M);
+
+        size_t out = (input_size == 0) ? 0 : input_size + M - 1;
+        size_t best = n;
+        for (; ; n *= 2) {
+            if (cost(n, M, out) < cost(best, M, out)) {
+                best = n;
+            } else if (out == 0 && n > 2 * best) {
+                // The work per output only grows from there on 
+                break;
+            }
+            if (out != 0 && n >= out) {
+                // A single block, larger ones only cost more
+                break;
+            }
+        }
+        return best;
+    }
+
+    static size_t output_size(size_t L, size_t M, ConvMode mode) noexcept {
+        switch (mode) {
+            case ConvMode::Same: return std::max(L, M);
+            case ConvMode::Valid: return std::max(L, M) - std::min(L, M) + 1;
+            default: return L + M - 1;
+        }
+    }
+
+    size_t output_size(size_t L, ConvMode mode) const noexcept {
+        return output_size(L, _kernel_size, mode);
+    }
+
+    // Writes the output_size(input.size(), mode) samples of mode to output,
+    // input and output must not overlap. The lengths are those of the views,
+    // and a view of a whole Vec includes its padding
+    MutView<T> operator()(ConstView<T> input, MutView<T> output, ConvMode mode = ConvMode::Full) const {
+        using BaseType = typename T::BaseType;
+        size_t L = input.size();
+        size_t M = _kernel_size;
+        size_t N = _block_size;
+        ASSERT(L >= 1);
+        size_t len = output_size(L, mode);
+        ASSERT(output.size() >= len);
+
+        MutView<T> wview(work);
+        size_t step = N - M + 1;
+        for (size_t j = 0; j < len; j += step) {
+            // The block holds inputs [s, s + N), its kept outputs are those of [s + M - 1, s + N)
+            int64_t s = static_cast<int64_t>(first(L, M, mode) + j) - static_cast<int64_t>(M - 1);
+            size_t lo = static_cast<size_t>(std::clamp<int64_t>(-s, 0, N));
+            size_t hi = static_cast<size_t>(std::clamp<int64_t>(static_cast<int64_t>(L) - s, lo, N));
+            std::fill(work.rdata(), work.rdata() + lo, BaseType(0.0));
+            std::fill(work.idata(), work.idata() + lo, BaseType(0.0));
+            if (hi > lo) {
+                std::memcpy(work.rdata() + lo, input.data().re + (s + lo), sizeof(BaseType) * (hi - lo));
+                std::memcpy(work.idata() + lo, input.data().im + (s + lo), sizeof(BaseType) * (hi - lo));
+            }
+            std::fill(work.rdata() + hi, work.rdata() + N, BaseType(0.0));
+            std::fill(work.idata() + hi, work.idata() + N, BaseType(0.0));
+
+            conv(wview);
+
+            size_t count = std::min(step, len - j);
+            std::memcpy(output.data().re + j, work.rdata() + (M - 1), sizeof(BaseType) * count);
+            std::memcpy(output.data().im + j, work.idata() + (M - 1), sizeof(BaseType) * count);
+        }
+        return output;
+    }
+
+    inline size_t kernel_size() const noexcept {
+        return _kernel_size;
+    }
+
+    inline size_t block_size() const noexcept {
+        return _block_size;
+    }
+};
+
+template class LinearConvolution<complex<double>>;
+
+// Convolution of a continuous stream with a kernel of any length, chunk by chunk
+//
+// Overlap-save as in LinearConvolution, over blocks of N samples of which the first 
+// M - 1 are the last inputs of the previous block. Every call takes a chunk of any size
+// and gives back as many outputs, delayed by latency() = N - M + 1 samples: output t is 
+// sample t - latency() of the convolution of the whole stream, and zero before it
+//
+// N defaults to the block size of LinearConvolution, the least work per output. Its latency
+// is not bounded: about 4096 samples for kernels up to a few hundred, and about 15 * M past
+// that. A maximum latency picks the largest block within it instead, see block_size()
+//
+// All buffers are allocated on construction, chunks do not allocate
+template <typename T> requires ComplexType<T>
+class StreamingConvolution {
+
+    public:
+    using AlgType = T;
+    using BaseType = typename T::BaseType;
+
+    private:
+    size_t _kernel_size;
+    size_t _block_size;
+    size_t _fill = 0; // Inputs of the current block so far
+    ConvolutionFunction<T> conv; // Holds the spectrum of the padded kernel
+    Vec<T> history; // The M - 1 inputs before the current block, followed by its inputs
+    Vec<T> ready; // Outputs of the previous block
+    Vec<T> work;
+
+    inline size_t step() const noexcept {
+        return _block_size - _kernel_size + 1;
+    }
+
+    void _block() {
+        size_t N = _block_size;
+        size_t keep = _kernel_size - 1;
+        std::memcpy(work.rdata(), history.rdata(), sizeof(BaseType) * N);
+        std::memcpy(work.idata(), history.idata(), sizeof(BaseType) * N);
+
+        MutView<T> wview(work);
+        conv(wview);
+
+        std::memcpy(ready.rdata(), work.rdata() + keep, sizeof(BaseType) * step());
+        std::memcpy(ready.idata(), work.idata() + keep, sizeof(BaseType) * step());
+        std::memmove(history.rdata(), history.rdata() + step(), sizeof(BaseType) * keep);
+        std::memmove(history.idata(), history.idata() + step(), sizeof(BaseType) * keep);
+        _fill = 0;
+    }
+
+    public:
+    // block_size is a power of two of at least the kernel size and one SIMD register,
+    // 0 picks it from max_latency (0 for no bound), see block_size()
+    StreamingConvolution(ConstView<T> kernel, size_t block_size = 0, size_t max_latency = 0) :
+        _kernel_size(kernel.size()), 
+        _block_size(block_size ? block_size : StreamingConvolution::block_size(kernel.size(), max_latency)),
+        conv(LinearConvolution<T>::make_kernel(kernel, _block_size)), 
+        history{_block_size}, ready{_block_size}, work{_block_size} {
+        ASSERT(kernel.size() >= 1);
+        ASSERT(util::is_pow2(_block_size) && _block_size >= kernel.size());
+        ASSERT(_block_size >= Arith<T>::OpCapacity);
+        reset();
+    }
+
+    // Feeds input to the stream and writes the input.size() next outputs to output
+    // input and output may be the same view, but must not otherwise overlap
+    MutView<T> operator()(ConstView<T> input, MutView<T> output) {
+        ASSERT(output.size() >= input.size());
+        size_t n = input.size();
+        size_t keep = _kernel_size - 1;
+        for (size_t done = 0; done < n; ) {
+            size_t take = std::min(n - done, step() - _fill);
+            // Inputs are read before outputs are written over them
+            std::memcpy(history.rdata() + (keep + _fill), input.data().re + done, sizeof(BaseType) * take);
+            std::memcpy(history.idata() + (keep + _fill), input.data().im + done, sizeof(BaseType) * take);
+            std::memcpy(output.data().re + done, ready.rdata() + _fill, sizeof(BaseType) * take);
+            std::memcpy(output.data().im + done, ready.idata() + _fill, sizeof(BaseType) * take);
+            _fill += take;
+            done += take;
+            if (_fill == step()) {
+                _block();
+            }
+        }
+        return output;
+    }
+
+    // Block size for a kernel of M samples whose latency is at most max_latency, 0 for any
+    // The work per output only falls up to the block of LinearConvolution, so the largest
+    // block within the bound is the cheapest. Bounds below the latency of the smallest block,
+    // util::fft_size(M) - M + 1, can not be met and get that block
+    static size_t block_size(size_t M, size_t max_latency = 0) noexcept {
+        size_t smallest = util::fft_size<Arith<T>::OpCapacity>(M);
+        size_t n = LinearConvolution<T>::block_size(M);
+        while (max_latency != 0 && n > smallest && n - M + 1 > max_latency) {
+            n /= 2;
+        }
+        return n;
+    }
+
+    // Restarts the stream, as if nothing had been fed
+    void reset() noexcept {
+        history.zero();
+        ready.zero();
+        _fill = 0;
+    }
+
+    inline size_t latency() const noexcept {
+        return step();
+    }
+
+    inline size_t kernel_size() const noexcept {
+        return _kernel_size;
+    }
+
+    inline size_t block_size() const noexcept {
+        return _block_size;
+    }
+};
+
+template class StreamingConvolution<complex<double>>;
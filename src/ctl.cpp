@@ -2,8 +2,10 @@
 #include <iostream>
 #include <fft.h>
 #include <chrono>
+#include <string>
 
-int main() {
+// Usage: ctl [threads]
+int main(int argc, char** argv) {
     Vec<cplx128_t> data{16777216};
     for (size_t i = 0; i < data.size(); i++) {
         data.rdata()[i] = .001 * i;
@@ -11,6 +13,9 @@ int main() {
     } 
 
     FFT<double> fft(data.size());
+    if (argc > 1) {
+        fft.threads = std::stoul(argv[1]);
+    }
     auto view = tview::view(data);
 
     auto t0 = std::chrono::system_clock::now();
@@ -4,8 +4,31 @@
 #include "tview.h"
 #include <common.h>
 #include <function.h>
+#include <parallel.h>
 #include <shuffler.h>
 #include <twiddle.h>
+#include <cmath>
+#include <concepts>
+
+// Order in which the butterfly layers are executed
+// BreadthFirst: Every layer is a full pass over the input
+// Recursive: Sub transforms are finished depth first while they fit in cache
+enum class FFTMode {
+    BreadthFirst,
+    Recursive
+};
+
+// Scaling of the transforms, folded into the shuffle so that it costs no extra pass
+// Backward: ifft() by 1/N, the usual convention
+// Forward: fft() by 1/N
+// Ortho: both by 1/sqrt(N), which makes the pair unitary
+// None: neither, ifft(fft(x)) = N * x
+enum class FFTNorm {
+    Backward,
+    Forward,
+    Ortho,
+    None
+};
 
 template <typename T> requires ScalarType<T>
 class FFT : public BaseFunction<complex<T>> {
@@ -14,7 +37,23 @@ class FFT : public BaseFunction<complex<T>> {
     using BaseType = T;
     using AlgType = complex<T>;
 
+    // Largest sub transform that is computed breadth first in recursive mode
+    // 2^14 complex doubles take up 256kB, which together with their twiddles
+    // should stay resident in a typical L2 cache
+    static constexpr size_t RECURSE_BLOCK = util::pow2(14);
+
+    // Transforms below this size always run on the calling thread only,
+    // as starting the threads would cost more than the transform itself
+    static constexpr size_t PARALLEL_MIN = RECURSE_BLOCK;
+
+    // Number of factors derived at once for the layers a compact table does not store
+    static constexpr size_t TWIDDLE_BLOCK = 256;
+
     bool forward = true;
+    FFTMode mode = FFTMode::Recursive;
+    FFTNorm norm = FFTNorm::Backward;
+    // Number of threads used by fft() and ifft(), including the calling thread
+    size_t threads = 1;
     private:
     ShuffleFunction<complex<T>> shuffler;
     const TwiddleStore<T> twiddles;
@@ -89,7 +128,7 @@ class FFT : public BaseFunction<complex<T>> {
 
     }
 
-    inline void _ifft_layer_n_impl(MutView<AlgType>& even, MutView<AlgType>& odd) const noexcept {
+    inline void _ifft_layer_n_impl(MutView<AlgType>& even, MutView<AlgType>& odd, ConstView<AlgType>& twid) const noexcept {
         // E = E + O 
         // O = (E - O) * W*_[0,N/2)
 
@@ -98,7 +137,6 @@ class FFT : public BaseFunction<complex<T>> {
         // E -> E + W_[0,N/2) * O -> E + W_[0,N/2) * O + E - W_[0,N/2) * O = 2*E
         // O -> E - W_[0,N/2) * O -> (E + W_[0,N/2) * O - E + W_[0,N/2) * O) * W*_[0,N/2) = 2 * W_[0,N/2) * O * W*_[0,N/2) * O =  2 * O
 
-        const auto& twid = twiddles.get_layer(2*even.size());
         altAddSubMultConj(even, odd, twid);
     }
 
@@ -116,78 +154,737 @@ class FFT : public BaseFunction<complex<T>> {
         altAddSubProd(even, odd, twid);
     }
 
-    inline void _fft_layer_impl(MutView<AlgType>& layer, size_t batch_size) const noexcept {
+    // There is no pointer arithmetic on const complex pointers
+    static inline ConstView<AlgType> _slice(const ConstView<AlgType>& view, size_t offset, size_t n) noexcept {
+        return ConstView<AlgType>(ccomplexptr<T>{view.data().re + offset, view.data().im + offset}, n);
+    }
+
+    // Runs f(lo, hi, w1, w2, w3) over [lo, hi), where w1 holds the factors [lo, hi) of the 
+    // layer of size n, and when QUAD, w2 and w3 those of the layer of size n / 2 and the cube layer
+    // Stored layers are handed out whole, the others are derived a block at a time into
+    // buffers on the stack, small enough to stay in L1 next to the butterflies (see TwiddleMode)
+    template <bool QUAD, typename F>
+    inline void _twiddle_blocks(size_t n, size_t lo, size_t hi, F&& f) const {
+        if (n <= twiddles.stored()) {
+            ConstView<AlgType> w1 = _slice(twiddles.get_layer(n), lo, hi - lo);
+            if constexpr (QUAD) {
+                ConstView<AlgType> w2 = _slice(twiddles.get_layer(n / 2), lo, hi - lo);
+                ConstView<AlgType> w3 = _slice(twiddles.get_cube_layer(n), lo, hi - lo);
+                f(lo, hi, w1, w2, w3);
+            } else {
+                f(lo, hi, w1, w1, w1);
+            }
+            return;
+        }
+
+        alignas(64) BaseType buf[QUAD ? 6 : 2][TWIDDLE_BLOCK];
+        for (size_t b = lo; b < hi; b += TWIDDLE_BLOCK) {
+            size_t len = std::min(TWIDDLE_BLOCK, hi - b);
+            MutView<AlgType> d1(complexptr<T>{buf[0], buf[1]}, len);
+            twiddles.load_layer(n, b, d1);
+            ConstView<AlgType> w1(d1.data(), len);
+            if constexpr (QUAD) {
+                MutView<AlgType> d2(complexptr<T>{buf[2], buf[3]}, len);
+                MutView<AlgType> d3(complexptr<T>{buf[4], buf[5]}, len);
+                twiddles.load_layer(n / 2, b, d2);
+                twiddles.load_cube_layer(n, b, d3);
+                ConstView<AlgType> w2(d2.data(), len);
+                ConstView<AlgType> w3(d3.data(), len);
+                f(b, b + len, w1, w2, w3);
+            } else {
+                f(b, b + len, w1, w1, w1);
+            }
+        }
+    }
+
+    // Runs body(i, lo, hi) for the niter batches of a layer, where [lo, hi) is 
+    // the range of butterflies of batch i to compute, out of width of them
+    //
+    // Layers with many small batches hand out whole batches to each thread, 
+    // (the independent sub transforms), while layers with few large batches 
+    // split the butterflies of every batch between the threads
+    template <typename F>
+    inline void _parallel_layer(size_t niter, size_t width, size_t threads, F&& body) const {
+        if (threads <= 1) {
+            for (size_t i = 0; i < niter; i++) {
+                body(i, 0, width);
+            }
+        } else if (niter >= threads) {
+            util::parallel_for(threads, niter, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    body(i, 0, width);
+                }
+            });
+        } else {
+            for (size_t i = 0; i < niter; i++) {
+                util::parallel_for<Arith<AlgType>::OpCapacity>(threads, width, [&](size_t lo, size_t hi) {
+                    body(i, lo, hi);
+                });
+            }
+        }
+    }
+
+    // store is called on every stretch of the output, right after it is computed 
+    // (see fft() with callbacks), only the last layer passes one
+    template <typename Store = NoCallback>
+    inline void _fft_layer_impl(MutView<AlgType>& layer, size_t batch_size, size_t threads = 1, const Store& store = {}) const {
         ASSERT(batch_size > 1);
-        int64_t niter = shuffler.size() / batch_size;
-        auto twid = twiddles.get_layer(batch_size);
-        for (int64_t i = 0; i < niter; i++) {
-            int64_t offset = batch_size * i;
-            MutView<AlgType> even(layer.data() + offset, batch_size / 2);
-            MutView<AlgType> odd(layer.data() + (offset + batch_size / 2), batch_size / 2);
+        size_t niter = layer.size() / batch_size;
+        size_t half = batch_size / 2;
+        // The size 2 and 4 kernels cannot be split
+        size_t width = (batch_size > 4) ? half : 1;
+        _parallel_layer(niter, width, threads, [&](size_t i, size_t lo, size_t hi) {
+            size_t offset = batch_size * i;
             if (batch_size == 2) {
+                MutView<AlgType> even(layer.data() + offset, 1);
+                MutView<AlgType> odd(layer.data() + (offset + 1), 1);
                 _fft_layer_2_impl(even, odd);
+                store(offset, MutView<AlgType>(layer.data() + offset, 2));
             } else if (batch_size == 4) {
+                MutView<AlgType> even(layer.data() + offset, 2);
+                MutView<AlgType> odd(layer.data() + (offset + 2), 2);
                 _fft_layer_4_impl(even, odd);
+                store(offset, MutView<AlgType>(layer.data() + offset, 4));
             } else {
-                _fft_layer_n_impl(even, odd, twid);
+                _twiddle_blocks<false>(batch_size, lo, hi, [&](size_t l, size_t h, ConstView<AlgType>& tw, auto&, auto&) {
+                    MutView<AlgType> even(layer.data() + (offset + l), h - l);
+                    MutView<AlgType> odd(layer.data() + (offset + half + l), h - l);
+                    _fft_layer_n_impl(even, odd, tw);
+                    store(offset + l, even);
+                    store(offset + half + l, odd);
+                });
             }
+        });
+    }
+
+    // Radix-4 transform of size 4, all of the twiddle factors are trivial (1, -j)
+    // Blocks are in bit reversed order, so a and b are the even samples while c and d are the odd ones
+    void _fft_quad_layer_4_impl(MutView<AlgType>& layer) const noexcept {
+        auto re = layer.data().re;
+        auto im = layer.data().im;
+
+        BaseType t0r = re[0] + re[1], t0i = im[0] + im[1];
+        BaseType t1r = re[0] - re[1], t1i = im[0] - im[1];
+        BaseType t2r = re[2] + re[3], t2i = im[2] + im[3];
+        BaseType t3r = re[2] - re[3], t3i = im[2] - im[3];
+
+        re[0] = t0r + t2r;
+        im[0] = t0i + t2i;
+        // W = -j
+        re[1] = t1r + t3i;
+        im[1] = t1i - t3r;
+        re[2] = t0r - t2r;
+        im[2] = t0i - t2i;
+        // W = j
+        re[3] = t1r - t3i;
+        im[3] = t1i + t3r;
+    }
+
+    void _ifft_quad_layer_4_impl(MutView<AlgType>& layer) const noexcept {
+        auto re = layer.data().re;
+        auto im = layer.data().im;
+
+        BaseType t0r = re[0] + re[2], t0i = im[0] + im[2];
+        BaseType t1r = re[1] + re[3], t1i = im[1] + im[3];
+        BaseType t2r = re[0] - re[2], t2i = im[0] - im[2];
+        // j * (b - d)
+        BaseType t3r = im[3] - im[1], t3i = re[1] - re[3];
+
+        re[0] = t0r + t1r;
+        im[0] = t0i + t1i;
+        re[1] = t0r - t1r;
+        im[1] = t0i - t1i;
+        re[2] = t2r + t3r;
+        im[2] = t2i + t3i;
+        re[3] = t2r - t3r;
+        im[3] = t2i - t3i;
+    }
+
+    // Merges two radix-2 layers (batch_size / 2 and batch_size) into one pass
+    // Each batch is split into quarters a, b, c, d, where (a, b) and (c, d) 
+    // would have been the even/odd pairs of the lower radix-2 layer
+    template <typename Store = NoCallback>
+    inline void _fft_quad_layer_impl(MutView<AlgType>& layer, size_t batch_size, size_t threads = 1, const Store& store = {}) const {
+        ASSERT(batch_size >= 4);
+        size_t niter = layer.size() / batch_size;
+        if (batch_size == 4) {
+            _parallel_layer(niter, 1, threads, [&](size_t i, size_t, size_t) {
+                MutView<AlgType> quad(layer.data() + 4 * i, 4);
+                _fft_quad_layer_4_impl(quad);
+                store(4 * i, quad);
+            });
+            return;
+        }
+
+        size_t quarter = batch_size / 4;
+        _parallel_layer(niter, quarter, threads, [&](size_t i, size_t lo, size_t hi) {
+            _twiddle_blocks<true>(batch_size, lo, hi, [&](size_t l, size_t h, ConstView<AlgType>& t1, ConstView<AlgType>& t2, ConstView<AlgType>& t3) {
+                size_t offset = batch_size * i + l;
+                size_t len = h - l;
+                MutView<AlgType> a(layer.data() + offset, len);
+                MutView<AlgType> b(layer.data() + (offset + quarter), len);
+                MutView<AlgType> c(layer.data() + (offset + 2 * quarter), len);
+                MutView<AlgType> d(layer.data() + (offset + 3 * quarter), len);
+                quadAddSubProd(a, b, c, d, t1, t2, t3);
+                store(offset, a);
+                store(offset + quarter, b);
+                store(offset + 2 * quarter, c);
+                store(offset + 3 * quarter, d);
+            });
+        });
+    }
+
+    // load is called on every stretch of the input, right before it is read
+    // (see ifft() with callbacks), only the first layer passes one
+    template <typename Load = NoCallback>
+    inline void _ifft_quad_layer_impl(MutView<AlgType>& layer, size_t batch_size, size_t threads = 1, const Load& load = {}) const {
+        ASSERT(batch_size >= 4);
+        size_t niter = layer.size() / batch_size;
+        if (batch_size == 4) {
+            _parallel_layer(niter, 1, threads, [&](size_t i, size_t, size_t) {
+                MutView<AlgType> quad(layer.data() + 4 * i, 4);
+                load(4 * i, quad);
+                _ifft_quad_layer_4_impl(quad);
+            });
+            return;
         }
+
+        size_t quarter = batch_size / 4;
+        _parallel_layer(niter, quarter, threads, [&](size_t i, size_t lo, size_t hi) {
+            _twiddle_blocks<true>(batch_size, lo, hi, [&](size_t l, size_t h, ConstView<AlgType>& t1, ConstView<AlgType>& t2, ConstView<AlgType>& t3) {
+                size_t offset = batch_size * i + l;
+                size_t len = h - l;
+                MutView<AlgType> a(layer.data() + offset, len);
+                MutView<AlgType> b(layer.data() + (offset + quarter), len);
+                MutView<AlgType> c(layer.data() + (offset + 2 * quarter), len);
+                MutView<AlgType> d(layer.data() + (offset + 3 * quarter), len);
+                load(offset, a);
+                load(offset + quarter, b);
+                load(offset + 2 * quarter, c);
+                load(offset + 3 * quarter, d);
+                quadAddSubMultConj(a, b, c, d, t1, t2, t3);
+            });
+        });
     }
 
-    inline void _ifft_layer_impl(MutView<AlgType>& layer, size_t batch_size) const noexcept {
+    template <typename Load = NoCallback>
+    inline void _ifft_layer_impl(MutView<AlgType>& layer, size_t batch_size, size_t threads = 1, const Load& load = {}) const {
         ASSERT(batch_size > 1);
-        int64_t niter = shuffler.size() / batch_size;
-        for (int64_t i = 0; i < niter; i++) {
-            int64_t offset = batch_size * i;
-            MutView<AlgType> even(layer.data() + offset, batch_size / 2);
-            MutView<AlgType> odd(layer.data() + (offset + batch_size / 2), batch_size / 2);
+        size_t niter = layer.size() / batch_size;
+        size_t half = batch_size / 2;
+        size_t width = (batch_size > 4) ? half : 1;
+        _parallel_layer(niter, width, threads, [&](size_t i, size_t lo, size_t hi) {
+            size_t offset = batch_size * i;
             if (batch_size == 2) {
+                load(offset, MutView<AlgType>(layer.data() + offset, 2));
+                MutView<AlgType> even(layer.data() + offset, 1);
+                MutView<AlgType> odd(layer.data() + (offset + 1), 1);
                 _ifft_layer_2_impl(even, odd);
             } else if (batch_size == 4) {
+                load(offset, MutView<AlgType>(layer.data() + offset, 4));
+                MutView<AlgType> even(layer.data() + offset, 2);
+                MutView<AlgType> odd(layer.data() + (offset + 2), 2);
                 _ifft_layer_4_impl(even, odd);
             } else {
-                _ifft_layer_n_impl(even, odd);
+                _twiddle_blocks<false>(batch_size, lo, hi, [&](size_t l, size_t h, ConstView<AlgType>& tw, auto&, auto&) {
+                    MutView<AlgType> even(layer.data() + (offset + l), h - l);
+                    MutView<AlgType> odd(layer.data() + (offset + half + l), h - l);
+                    load(offset + l, even);
+                    load(offset + half + l, odd);
+                    _ifft_layer_n_impl(even, odd, tw);
+                });
+            }
+        });
+    }
+
+    // Radix-4 layers halve the number of passes over memory and save a 
+    // quarter of the twiddle multiplications. When log2(N) is odd, a single 
+    // radix-2 layer finishes the transform at the full size
+    //
+    // done is the size of the sub transforms already completed by the shuffle,
+    // the layers below it are skipped (see ShuffleFusion)
+    //
+    // store goes with the last layer and load with the first one of the inverse,
+    // or over the whole data when there are no layers left
+    template <typename Store = NoCallback>
+    void _fft_impl_radix4(MutView<AlgType>& data, size_t threads = 1, size_t done = 1, const Store& store = {}) const {
+        size_t n = data.size();
+        if (n <= done) {
+            store(0, data);
+            return;
+        }
+        size_t batch_size = 4 * done;
+        for (; batch_size < n; batch_size *= 4) {
+            _fft_quad_layer_impl(data, batch_size, threads);
+        }
+        if (batch_size == n) {
+            _fft_quad_layer_impl(data, n, threads, store);
+        } else {
+            _fft_layer_impl(data, n, threads, store);
+        }
+    }
+
+    template <typename Load = NoCallback>
+    void _ifft_impl_radix4(MutView<AlgType>& data, size_t threads = 1, size_t done = 1, const Load& load = {}) const {
+        size_t batch_size = data.size();
+        if (batch_size <= done) {
+            load(0, data);
+            return;
+        }
+        if ((shuffle::num_bits(batch_size) - shuffle::num_bits(done)) % 2 == 1) {
+            _ifft_layer_impl(data, batch_size, threads, load);
+            batch_size /= 2;
+        } else {
+            _ifft_quad_layer_impl(data, batch_size, threads, load);
+            batch_size /= 4;
+        }
+        for (; batch_size >= 4 * done; batch_size /= 4) {
+            _ifft_quad_layer_impl(data, batch_size, threads);
+        }
+    }
+
+    // Depth first version of the radix-4 algorithm
+    // Every sub transform is completed while it is still resident in cache,
+    // only the layers above RECURSE_BLOCK make their own pass over the block
+    //
+    // With multiple threads, the sub transforms are spread over the threads,
+    // and the butterflies of the layer joining them are split between all of them
+    template <typename Store = NoCallback>
+    void _fft_impl_recursive(MutView<AlgType>& data, size_t threads = 1, size_t done = 1, const Store& store = {}) const {
+        size_t n = data.size();
+        if (n <= RECURSE_BLOCK) {
+            _fft_impl_radix4(data, 1, done, store);
+            return;
+        }
+
+        size_t parts = (shuffle::num_bits(n) % 2 == 1) ? 2 : 4;
+        size_t sub_threads = std::max<size_t>(threads / parts, 1);
+        util::parallel_for(std::min(threads, parts), parts, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                MutView<AlgType> sub(data.data() + i * (n / parts), n / parts);
+                _fft_impl_recursive(sub, sub_threads, done);
+            }
+        });
+
+        if (parts == 2) {
+            _fft_layer_impl(data, n, threads, store);
+        } else {
+            _fft_quad_layer_impl(data, n, threads, store);
+        }
+    }
+
+    template <typename Load = NoCallback>
+    void _ifft_impl_recursive(MutView<AlgType>& data, size_t threads = 1, size_t done = 1, const Load& load = {}) const {
+        size_t n = data.size();
+        if (n <= RECURSE_BLOCK) {
+            _ifft_impl_radix4(data, 1, done, load);
+            return;
+        }
+
+        size_t parts = (shuffle::num_bits(n) % 2 == 1) ? 2 : 4;
+        if (parts == 2) {
+            _ifft_layer_impl(data, n, threads, load);
+        } else {
+            _ifft_quad_layer_impl(data, n, threads, load);
+        }
+
+        size_t sub_threads = std::max<size_t>(threads / parts, 1);
+        util::parallel_for(std::min(threads, parts), parts, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                MutView<AlgType> sub(data.data() + i * (n / parts), n / parts);
+                _ifft_impl_recursive(sub, sub_threads, done);
+            }
+        });
+    }
+
+    // Convolution without bit reversals
+    // The decimation in frequency layers of ifft() take data in natural order and leave
+    // it in bit reversed order, which is the order the decimation in time layers of fft()
+    // start from. The pointwise product does not care about the order as long as the kernel 
+    // is in the same one, and the convolution theorem holds for either sign of the exponent, 
+    // so the ifft() layers, the product and the fft() layers make up the whole convolution
+    //
+    // The innermost size 4 layers of both directions and the product are done together, 4 points at a time
+    void _convolve_quad_4_impl(MutView<AlgType>& quad, const ConstView<AlgType>& kernel) const noexcept {
+        _ifft_quad_layer_4_impl(quad);
+        auto re = quad.data().re;
+        auto im = quad.data().im;
+        for (size_t i = 0; i < 4; i++) {
+            BaseType kr = kernel.data().re[i], ki = kernel.data().im[i];
+            BaseType tr = re[i] * kr - im[i] * ki;
+            im[i] = re[i] * ki + im[i] * kr;
+            re[i] = tr;
+        }
+        _fft_quad_layer_4_impl(quad);
+    }
+
+    // The breadth first convolution, also the base case of the recursive one
+    void _convolve_radix4(MutView<AlgType>& data, const ConstView<AlgType>& kernel, size_t threads = 1) const {
+        size_t n = data.size();
+        if (n < 4) {
+            _ifft_impl_radix4(data);
+            data *= kernel;
+            _fft_impl_radix4(data);
+            return;
+        }
+
+        _ifft_impl_radix4(data, threads, 4);
+        util::parallel_for<4>(threads, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i += 4) {
+                MutView<AlgType> quad(data.data() + i, 4);
+                _convolve_quad_4_impl(quad, _slice(kernel, i, 4));
             }
+        });
+        _fft_impl_radix4(data, threads, 4);
+    }
+
+    // Same structure as the recursive transforms, every block of RECURSE_BLOCK goes through
+    // the innermost layers of both directions and the product while it is in cache
+    void _convolve_recursive(MutView<AlgType>& data, const ConstView<AlgType>& kernel, size_t threads = 1) const {
+        size_t n = data.size();
+        if (n <= RECURSE_BLOCK) {
+            _convolve_radix4(data, kernel);
+            return;
         }
+
+        size_t parts = (shuffle::num_bits(n) % 2 == 1) ? 2 : 4;
+        if (parts == 2) {
+            _ifft_layer_impl(data, n, threads);
+        } else {
+            _ifft_quad_layer_impl(data, n, threads);
+        }
+
+        size_t sub_threads = std::max<size_t>(threads / parts, 1);
+        util::parallel_for(std::min(threads, parts), parts, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                MutView<AlgType> sub(data.data() + i * (n / parts), n / parts);
+                _convolve_recursive(sub, _slice(kernel, i * (n / parts), n / parts), sub_threads);
+            }
+        });
+
+        if (parts == 2) {
+            _fft_layer_impl(data, n, threads);
+        } else {
+            _fft_quad_layer_impl(data, n, threads);
+        }
+    }
+
+    // One radix-2 stage of the Stockham autosort algorithm, from src into dst
+    // n is the length of the current sub transforms and s the distance between their elements
+    //
+    // dst[q + s*2p]     = src[q + s*p] + src[q + s*(p + n/2)]
+    // dst[q + s*(2p+1)] = (src[q + s*p] - src[q + s*(p + n/2)]) * W_n^p
+    //
+    // The elements of each pair move to their sorted positions within the butterfly,
+    // which removes the need for the bit reversal at the cost of an out of place pass
+    void _stockham_stage_impl(MutView<AlgType>& src, MutView<AlgType>& dst, size_t n, size_t s, bool inverse) const noexcept {
+        size_t m = n / 2;
+        if (s >= Arith<AlgType>::OpCapacity) {
+            _twiddle_blocks<false>(n, 0, m, [&](size_t lo, size_t hi, ConstView<AlgType>& twid, auto&, auto&) {
+                for (size_t p = lo; p < hi; p++) {
+                    MutView<AlgType> a(src.data() + s * p, s);
+                    MutView<AlgType> b(src.data() + s * (p + m), s);
+                    MutView<AlgType> outa(dst.data() + s * 2 * p, s);
+                    MutView<AlgType> outb(dst.data() + s * (2 * p + 1), s);
+                    if (inverse) {
+                        altAddSubMultConjScalar(outa, outb, a, b, twid[p - lo]);
+                    } else {
+                        altAddSubMultScalar(outa, outb, a, b, twid[p - lo]);
+                    }
+                }
+            });
+            return;
+        }
+
+        // Strides too small to fill a SIMD register
+        auto in = src.data();
+        auto out = dst.data();
+        _twiddle_blocks<false>(n, 0, m, [&](size_t lo, size_t hi, ConstView<AlgType>& twid, auto&, auto&) {
+            for (size_t p = lo; p < hi; p++) {
+                BaseType wr = twid[p - lo].re;
+                BaseType wi = inverse ? -twid[p - lo].im : twid[p - lo].im;
+                for (size_t q = 0; q < s; q++) {
+                    size_t ia = q + s * p, ib = q + s * (p + m);
+                    BaseType dr = in.re[ia] - in.re[ib];
+                    BaseType di = in.im[ia] - in.im[ib];
+                    size_t oa = q + s * 2 * p, ob = q + s * (2 * p + 1);
+                    out.re[oa] = in.re[ia] + in.re[ib];
+                    out.im[oa] = in.im[ia] + in.im[ib];
+                    out.re[ob] = dr * wr - di * wi;
+                    out.im[ob] = dr * wi + di * wr;
+                }
+            }
+        });
     }
 
-    // The trivial algorithm
-    // This will be used as a base algorithm to test other finer-tuned
-    // implementations that allow for better caching of data
-    void _fft_impl(MutView<AlgType>& data) const noexcept {
-        for (size_t batch_size = 2; batch_size <= data.size(); batch_size *= 2) {
-            _fft_layer_impl(data, batch_size);
+    // Radix-4 Stockham stage, the quarters of each sub transform are combined as
+    //
+    // dst[q + s*4p]     = (a + c) + (b + d)
+    // dst[q + s*(4p+1)] = ((a - c) - j(b - d)) * W_n^p
+    // dst[q + s*(4p+2)] = ((a + c) - (b + d)) * W_n^2p
+    // dst[q + s*(4p+3)] = ((a - c) + j(b - d)) * W_n^3p
+    //
+    // Where a, b, c, d = src[q + s*p], src[q + s*(p + n/4)], src[q + s*(p + n/2)], src[q + s*(p + 3n/4)]
+    void _stockham_quad_stage_impl(MutView<AlgType>& src, MutView<AlgType>& dst, size_t n, size_t s, bool inverse) const noexcept {
+        size_t m = n / 4;
+        if (s >= Arith<AlgType>::OpCapacity) {
+            _twiddle_blocks<true>(n, 0, m, [&](size_t lo, size_t hi, ConstView<AlgType>& w1, ConstView<AlgType>& w2, ConstView<AlgType>& w3) {
+                for (size_t p = lo; p < hi; p++) {
+                    MutView<AlgType> a(src.data() + s * p, s);
+                    MutView<AlgType> b(src.data() + s * (p + m), s);
+                    MutView<AlgType> c(src.data() + s * (p + 2 * m), s);
+                    MutView<AlgType> d(src.data() + s * (p + 3 * m), s);
+                    MutView<AlgType> out0(dst.data() + s * 4 * p, s);
+                    MutView<AlgType> out1(dst.data() + s * (4 * p + 1), s);
+                    MutView<AlgType> out2(dst.data() + s * (4 * p + 2), s);
+                    MutView<AlgType> out3(dst.data() + s * (4 * p + 3), s);
+                    if (inverse) {
+                        quadAddSubMultConjScalar(out0, out2, out1, out3, a, b, c, d, w1[p - lo], w2[p - lo], w3[p - lo]);
+                    } else {
+                        quadAddSubMultScalar(out0, out2, out1, out3, a, b, c, d, w1[p - lo], w2[p - lo], w3[p - lo]);
+                    }
+                }
+            });
+            return;
         }
+
+        // Strides too small to fill a SIMD register
+        auto in = src.data();
+        auto out = dst.data();
+        BaseType sign = inverse ? -1.0 : 1.0;
+        auto mult = [](BaseType& r, BaseType& i, BaseType wr, BaseType wi) {
+            BaseType tr = r * wr - i * wi;
+            i = r * wi + i * wr;
+            r = tr;
+        };
+        _twiddle_blocks<true>(n, 0, m, [&](size_t lo, size_t hi, ConstView<AlgType>& w1, ConstView<AlgType>& w2, ConstView<AlgType>& w3) {
+            for (size_t p = lo; p < hi; p++) {
+                BaseType w1r = w1[p - lo].re, w1i = sign * w1[p - lo].im;
+                BaseType w2r = w2[p - lo].re, w2i = sign * w2[p - lo].im;
+                BaseType w3r = w3[p - lo].re, w3i = sign * w3[p - lo].im;
+                for (size_t q = 0; q < s; q++) {
+                    size_t ia = q + s * p, ib = ia + s * m, ic = ib + s * m, id = ic + s * m;
+                    BaseType t0r = in.re[ia] + in.re[ic], t0i = in.im[ia] + in.im[ic];
+                    BaseType t1r = in.re[ib] + in.re[id], t1i = in.im[ib] + in.im[id];
+                    BaseType t2r = in.re[ia] - in.re[ic], t2i = in.im[ia] - in.im[ic];
+                    // -j * (b - d) going forward, j * (b - d) going backward
+                    BaseType t3r = sign * (in.im[ib] - in.im[id]), t3i = sign * (in.re[id] - in.re[ib]);
+
+                    BaseType y0r = t0r + t1r, y0i = t0i + t1i;
+                    BaseType y1r = t2r + t3r, y1i = t2i + t3i;
+                    BaseType y2r = t0r - t1r, y2i = t0i - t1i;
+                    BaseType y3r = t2r - t3r, y3i = t2i - t3i;
+                    mult(y1r, y1i, w1r, w1i);
+                    mult(y2r, y2i, w2r, w2i);
+                    mult(y3r, y3i, w3r, w3i);
+
+                    size_t o = q + s * 4 * p;
+                    out.re[o] = y0r;
+                    out.im[o] = y0i;
+                    out.re[o + s] = y1r;
+                    out.im[o + s] = y1i;
+                    out.re[o + 2 * s] = y2r;
+                    out.im[o + 2 * s] = y2i;
+                    out.re[o + 3 * s] = y3r;
+                    out.im[o + 3 * s] = y3i;
+                }
+            }
+        });
     }
 
-    void _ifft_impl(MutView<AlgType>& data) const noexcept {
-        for (size_t batch_size = shuffler.size(); batch_size >= 2; batch_size /= 2) {
-            _ifft_layer_impl(data, batch_size);
+    // Stages ping-pong between data and work. The final stage (n = 4 or n = 2) 
+    // only has a single butterfly per column, reading and writing the same 
+    // positions, so it can always write into data regardless of where its input lies
+    void _stockham_impl(MutView<AlgType>& data, MutView<AlgType>& work, bool inverse) const noexcept {
+        MutView<AlgType>* src = &data;
+        MutView<AlgType>* dst = &work;
+        size_t n = data.size();
+        size_t s = 1;
+        for (; n > 4; n /= 4, s *= 4) {
+            _stockham_quad_stage_impl(*src, *dst, n, s, inverse);
+            std::swap(src, dst);
         }
 
-        AlgType mult{1.0 / (1.0 * shuffler.size()), 0.0};
-        data *= mult;
+        if (n == 4) {
+            _stockham_quad_stage_impl(*src, data, n, s, inverse);
+        } else if (n == 2) {
+            _stockham_stage_impl(*src, data, n, s, inverse);
+        }
+    }
+
+    inline size_t _threads() const noexcept {
+        return (size() < PARALLEL_MIN) ? 1 : std::max<size_t>(threads, 1);
+    }
+
+    template <typename Store = NoCallback>
+    void _fft_impl(MutView<AlgType>& input, size_t done = 1, const Store& store = {}) const {
+        // Views over a Vec may include its alignment padding
+        MutView<AlgType> data(input.data(), size());
+        if (mode == FFTMode::Recursive) {
+            _fft_impl_recursive(data, _threads(), done, store);
+        } else {
+            _fft_impl_radix4(data, _threads(), done, store);
+        }
+    }
+
+    template <typename Load = NoCallback>
+    void _ifft_impl(MutView<AlgType>& input, size_t done = 1, const Load& load = {}) const {
+        MutView<AlgType> data(input.data(), size());
+        if (mode == FFTMode::Recursive) {
+            _ifft_impl_recursive(data, _threads(), done, load);
+        } else {
+            _ifft_impl_radix4(data, _threads(), done, load);
+        }
+    }
+
+    // Factor the output of fft() (inverse = false) or ifft() is multiplied by
+    BaseType _scale(bool inverse) const noexcept {
+        switch (norm) {
+            case FFTNorm::Backward: return inverse ? BaseType(1.0 / (1.0 * size())) : BaseType(1.0);
+            case FFTNorm::Forward: return inverse ? BaseType(1.0) : BaseType(1.0 / (1.0 * size()));
+            case FFTNorm::Ortho: return BaseType(1.0 / std::sqrt(1.0 * size()));
+            default: return BaseType(1.0);
+        }
+    }
+
+    // Only used by the autosort transforms, which have no shuffle to fold it into
+    void _normalize(MutView<AlgType>& data, bool inverse) const {
+        _scale_by(data, _scale(inverse));
+    }
+
+    // Multiplies the size() elements of data by scale
+    void _scale_by(MutView<AlgType>& data, BaseType scale) const {
+        if (scale == BaseType(1.0)) return;
+
+        AlgType mult{scale, 0.0};
+        util::parallel_for<Arith<AlgType>::OpCapacity>(_threads(), size(), [&](size_t begin, size_t end) {
+            MutView<AlgType> part(data.data() + begin, end - begin);
+            part *= mult;
+        });
     }
 
     public:
-    FFT(size_t N, bool forward = true) : forward(forward), shuffler(N), twiddles(N) {
+    // TwiddleMode::Compact trades a few percent of speed on the layers above 
+    // TwiddleTable::COMPACT_FULL for about a tenth of the twiddle memory (see TwiddleMode)
+    // threads sets the threads member, and also builds the twiddle table when this is the
+    // first transform of its size
+    FFT(size_t N, bool forward = true, TwiddleMode twiddle_mode = TwiddleMode::Full, size_t threads = 1) : 
+        forward(forward), threads(threads), shuffler(N), twiddles(N, twiddle_mode, threads) {
         ASSERT(util::is_pow2(N)); 
     }
 
+    // The first layers are done by the shuffle while each block is in its buffer,
+    // along with the normalization (see FFTNorm)
     MutView<AlgType> fft(MutView<AlgType> input) const {
-        input = shuffler(input);
-        _fft_impl(input);
+        return fft(input, NoCallback{}, NoCallback{});
+    }
+
+    MutView<AlgType> ifft(MutView<AlgType> input) const {
+        return ifft(input, NoCallback{}, NoCallback{});
+    }
+
+    // Transforms with elementwise work on their input and output, such as a window 
+    // or a filter. load(offset, chunk) is called on the input before the transform 
+    // reads it, and store(offset, chunk) on the output once it is final, where chunk 
+    // is a MutView of the elements [offset, offset + chunk.size()) in natural order
+    // ScalerFunction, AddFunction, SumFunction, MultFunction, ProductFunction and 
+    // ConjFunction all have an operator()(offset, chunk) of this form
+    // Every element goes through each of them once, in chunks of varying sizes and order, 
+    // concurrently with threads > 1
+    //
+    // Neither costs a pass of its own: the side of the shuffle runs within it, on each
+    // run of the input as it is gathered into the COBRA buffer or of the output as it is 
+    // scattered, and the other side within the last or first butterfly layer
+    template <typename Load, typename Store = NoCallback>
+        requires std::invocable<const Load&, size_t, MutView<AlgType>> &&
+                 std::invocable<const Store&, size_t, MutView<AlgType>>
+    MutView<AlgType> fft(MutView<AlgType> input, const Load& load, const Store& store = {}) const {
+        input = shuffler(input, _threads(), ShuffleFusion::Forward, _scale(false), load);
+        _fft_impl(input, util::pow2(shuffler.fused_layers()), store);
 
         return input;
     }
 
-    MutView<AlgType> ifft(MutView<AlgType> input) const {
-        _ifft_impl(input);
-        input = shuffler(input);
+    template <typename Load, typename Store = NoCallback>
+        requires std::invocable<const Load&, size_t, MutView<AlgType>> &&
+                 std::invocable<const Store&, size_t, MutView<AlgType>>
+    MutView<AlgType> ifft(MutView<AlgType> input, const Load& load, const Store& store = {}) const {
+        _ifft_impl(input, util::pow2(shuffler.fused_layers()), load);
+        input = shuffler(input, _threads(), ShuffleFusion::Inverse, _scale(true), NoCallback{}, store);
   
         return input;
     }
 
+    // Out of place transforms, which leave in untouched
+    // The shuffle reads from in and writes to out, in place of a copy followed by a shuffle
+    // in and out may be the same view (the in place transform) but must not otherwise overlap
+    MutView<AlgType> fft(ConstView<AlgType> in, MutView<AlgType> out) const {
+        ASSERT(out.size() >= size());
+        if (in.data().re == out.data().re) {
+            return fft(out);
+        }
+        shuffler(in, out, _threads(), ShuffleFusion::Forward, _scale(false));
+        _fft_impl(out, util::pow2(shuffler.fused_layers()));
+
+        return out;
+    }
+
+    // The inverse reads in at negated indices and runs the forward layers (see ShuffleFunction)
+    MutView<AlgType> ifft(ConstView<AlgType> in, MutView<AlgType> out) const {
+        ASSERT(out.size() >= size());
+        if (in.data().re == out.data().re) {
+            return ifft(out);
+        }
+        shuffler(in, out, _threads(), ShuffleFusion::Forward, _scale(true), true);
+        _fft_impl(out, util::pow2(shuffler.fused_layers()));
+
+        return out;
+    }
+
+    // Autosorting transforms, the result is in natural order without a bit reversal pass
+    // work must hold at least size() elements and is overwritten
+    MutView<AlgType> fft_autosort(MutView<AlgType> input, MutView<AlgType> work) const {
+        ASSERT(work.size() >= size());
+        MutView<AlgType> data(input.data(), size());
+        _stockham_impl(data, work, false);
+        _normalize(data, false);
+
+        return input;
+    }
+
+    MutView<AlgType> ifft_autosort(MutView<AlgType> input, MutView<AlgType> work) const {
+        ASSERT(work.size() >= size());
+        MutView<AlgType> data(input.data(), size());
+        _stockham_impl(data, work, true);
+        _normalize(data, true);
+
+        return input;
+    }
+
+    // Turns kernel into the form convolve() takes, in place
+    // This is not the output of fft(): the spectrum is in bit reversed order, computed with 
+    // the sign of ifft() and already divided by N, so that convolve() needs no further pass
+    MutView<AlgType> convolution_kernel(MutView<AlgType> kernel) const {
+        MutView<AlgType> data(kernel.data(), size());
+        _ifft_impl(data);
+        _scale_by(data, BaseType(1.0 / (1.0 * size())));
+        return kernel;
+    }
+
+    // Circular convolution of input with a kernel from convolution_kernel(), in place
+    // Neither direction runs the bit reversal, the kernel is multiplied in between the
+    // innermost layers (see _convolve_quad_4_impl). norm does not apply
+    MutView<AlgType> convolve(MutView<AlgType> input, ConstView<AlgType> kernel) const {
+        ASSERT(kernel.size() >= size());
+        MutView<AlgType> data(input.data(), size());
+        if (mode == FFTMode::Recursive) {
+            _convolve_recursive(data, kernel, _threads());
+        } else {
+            _convolve_radix4(data, kernel, _threads());
+        }
+        return input;
+    }
+
     MutView<AlgType> operator()(MutView<AlgType> input) const override {
         if (forward) return fft(std::move(input));
         else return ifft(std::move(input));
@@ -197,9 +894,18 @@ class FFT : public BaseFunction<complex<T>> {
         return 1;
     }
 
-    inline size_t size() noexcept {
+    inline size_t size() const noexcept {
         return shuffler.size();
     }
+
+    // Block size of the COBRA bit reversal, see ShuffleFunction
+    inline void set_shuffle_bits(size_t q) noexcept {
+        shuffler.set_block_bits(q);
+    }
+
+    inline size_t shuffle_bits() const noexcept {
+        return shuffler.block_bits();
+    }
 };
 
 template class FFT<double>;
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "tview.h"
+#include <common.h>
+#include <batchfft.h>
+#include <transpose.h>
+#include <vector>
+#include <memory>
+
+// Multi dimensional FFT over a row major grid, through row-column decomposition
+//
+// The transform along every axis is a batch of one dimensional transforms.
+// Along the last axis those are the contiguous rows. For any other axis k the
+// grid is seen, for every index of the axes before k, as a d_k x inner matrix 
+// (inner being the product of the dimensions after k). That matrix is
+// transposed into the workspace, so the sequences along k become contiguous
+// rows, transformed as a batch and transposed back. The transposes are cache
+// blocked, so no axis is ever walked with a stride.
+//
+// This matches the layout of a Vec{d0, d1, ...}, the padding added to the first
+// dimension of a complex Vec lies past the end of the grid and is left untouched.
+template <typename T> requires ScalarType<T>
+class FFTND {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+
+    private:
+    std::vector<size_t> _dims;
+    size_t _size;
+    std::vector<std::unique_ptr<BatchFFT<T>>> axis_fft;
+    mutable Vec<AlgType> work;
+
+    void _axis_impl(MutView<AlgType>& data, size_t axis, bool inverse) const {
+        size_t n = _dims[axis];
+        if (n == 1) return;
+
+        size_t inner = 1;
+        for (size_t k = axis + 1; k < _dims.size(); k++) {
+            inner *= _dims[k];
+        }
+        size_t outer = _size / (n * inner);
+        const auto& batch = *axis_fft[axis];
+
+        if (inner == 1) {
+            if (inverse) {
+                batch.ifft(data, outer);
+            } else {
+                batch.fft(data, outer);
+            }
+            return;
+        }
+
+        MutView<AlgType> wview(work.data_ptr(), n * inner);
+        for (size_t o = 0; o < outer; o++) {
+            auto block = data.data() + o * n * inner;
+            transpose::blocked(ccomplexptr<T>{block.re, block.im}, work.data_ptr(), n, inner);
+            if (inverse) {
+                batch.ifft(wview, inner);
+            } else {
+                batch.fft(wview, inner);
+            }
+            transpose::blocked(ccomplexptr<T>{work.rdata(), work.idata()}, block, inner, n);
+        }
+    }
+
+    void _fft_impl(MutView<AlgType>& data, bool inverse) const {
+        // The last axis first, the others then read whatever is still in cache from it
+        for (size_t axis = _dims.size(); axis-- > 0;) {
+            _axis_impl(data, axis, inverse);
+        }
+    }
+
+    public:
+    // Every dimension must be a power of two
+    FFTND(std::initializer_list<size_t> dims) : _dims(dims), _size(1) {
+        ASSERT(_dims.size() >= 1);
+        for (size_t d : _dims) {
+            ASSERT(util::is_pow2(d));
+            _size *= d;
+            axis_fft.push_back(std::make_unique<BatchFFT<T>>(d));
+        }
+        // Only the axes before the last go through the workspace, the first one needing all of the grid
+        if (_dims.size() > 1) {
+            work = Vec<AlgType>{_size};
+        }
+    }
+
+    // Transforms along every axis
+    MutView<AlgType> fft(MutView<AlgType> data) const {
+        ASSERT(data.size() >= _size);
+        _fft_impl(data, false);
+        return data;
+    }
+
+    MutView<AlgType> ifft(MutView<AlgType> data) const {
+        ASSERT(data.size() >= _size);
+        _fft_impl(data, true);
+        return data;
+    }
+
+    // Transforms along a single axis
+    MutView<AlgType> fft_axis(MutView<AlgType> data, size_t axis) const {
+        ASSERT(data.size() >= _size && axis < _dims.size());
+        _axis_impl(data, axis, false);
+        return data;
+    }
+
+    MutView<AlgType> ifft_axis(MutView<AlgType> data, size_t axis) const {
+        ASSERT(data.size() >= _size && axis < _dims.size());
+        _axis_impl(data, axis, true);
+        return data;
+    }
+
+    inline const std::vector<size_t>& dims() const noexcept {
+        return _dims;
+    }
+
+    // Number of points of the whole grid
+    inline size_t size() const noexcept {
+        return _size;
+    }
+};
+
+template class FFTND<double>;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "tview.h"
+#include <common.h>
+#include <arith.h>
+
+// FFT of a size fixed at compile time
+//
+// Sizes up to MAX_SIZE are generated as straight line code (see arith/codelet.h),
+// with no shuffle pass and no twiddle tables, which beats the general FFT by a wide
+// margin on the small transforms where setup and indexing dominate.
+//
+// fft and ifft transform a single signal on scalar complex values: the codelets only
+// fill SIMD registers with one element of several signals, which a single transform
+// does not have. Many signals of the same size are better served by BatchFFT, which
+// runs the same codelets on a register of signals at a time.
+template <typename T, size_t N> requires ScalarType<T>
+class FixedFFT {
+    static_assert(util::is_pow2(N) && N <= 64, "Codelets are generated for powers of two up to 64");
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    using tarith = carith<AlgType>;
+
+    static constexpr size_t MAX_SIZE = 64;
+
+    MutView<AlgType> fft(MutView<AlgType> data) const noexcept {
+        ASSERT(data.size() >= N);
+        tarith::template _fcodelet<N, false>(data.data(), 1, 1);
+        return data;
+    }
+
+    // Normalized by 1/N, folded into the last stage of the codelet
+    MutView<AlgType> ifft(MutView<AlgType> data) const noexcept {
+        ASSERT(data.size() >= N);
+        tarith::template _fcodelet<N, true, false, true>(data.data(), 1, 1);
+        return data;
+    }
+
+    static constexpr size_t size() noexcept {
+        return N;
+    }
+};
+
+template class FixedFFT<double, 8>;
+template class FixedFFT<double, 16>;
+template class FixedFFT<double, 32>;
+template class FixedFFT<double, 64>;
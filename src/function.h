@@ -129,6 +129,11 @@ class ScalerFunction : public BaseFunction<T> {
         return input;
     }
 
+    MutView<T> operator()(size_t, MutView<T> chunk) const {
+        chunk *= _scale;
+        return chunk;
+    }
+
     constexpr size_t input_size() const override {
         return 1;
     }
@@ -151,6 +156,11 @@ class AddFunction : public BaseFunction<T> {
         return input;
     }
 
+    MutView<T> operator()(size_t, MutView<T> chunk) const {
+        chunk += delta;
+        return chunk;
+    }
+
     constexpr size_t input_size() const override {
         return 1;
     } 
@@ -201,6 +211,11 @@ class SumFunction : public BaseFunction<T> {
         return input;
     }
 
+    MutView<T> operator()(size_t offset, MutView<T> chunk) const {
+        chunk += ConstView<T>(summand, offset, chunk.size());
+        return chunk;
+    }
+
     constexpr size_t input_size() const override {
         return 1;
     }
@@ -227,6 +242,11 @@ class MultFunction : public BaseFunction<T> {
         input *= mview;
         return input;
     }
+
+    MutView<T> operator()(size_t offset, MutView<T> chunk) const {
+        chunk *= ConstView<T>(multiplicand, offset, chunk.size());
+        return chunk;
+    }
 };
 
 template<typename T>
@@ -244,6 +264,11 @@ class ProductFunction : public BaseFunction<T> {
         return input;
     }
 
+    MutView<T> operator()(size_t offset, MutView<T> chunk) const {
+        chunk *= ConstView<T>(multiplicand, offset, chunk.size());
+        return chunk;
+    }
+
     constexpr size_t input_size() const override {
         return 1;
     }
@@ -268,6 +293,10 @@ class ConjFunction : public BaseFunction<T> {
         return input;
     }
 
+    MutView<T> operator()(size_t, MutView<T> chunk) const {
+        return operator()(chunk);
+    }
+
     constexpr size_t input_size() const override {
         return 1;
     }
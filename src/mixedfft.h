@@ -0,0 +1,217 @@
+#pragma once
+
+#include "operation.h"
+#include "tview.h"
+#include <common.h>
+#include <function.h>
+#include <twiddle.h>
+#include <array>
+#include <vector>
+
+// FFT for sizes of the form 2^a * 3^b * 5^c * 7^d
+//
+// The transform is carried out as a sequence of Stockham autosort stages,
+// one per factor of N. Every stage reads from one buffer and writes into
+// the other, placing its outputs in sorted order, so there is no digit
+// reversal pass. Radix 4 and 2 stages are placed first: their strides
+// are then multiples of the SIMD width for the remaining stages.
+// The stages ping-pong with an internal workspace of N elements.
+//
+// A stage whose stride fills a register runs one butterfly at a time, over
+// the positions of the stride (unaligned when the stride is not a multiple
+// of the register). The first stages have strides below the register width
+// and instead run one butterfly per lane, which takes a table of the twiddles
+// of every lane (about N elements per such stage).
+template <typename T> requires ScalarType<T>
+class MixedRadixFFT : public BaseFunction<complex<T>> {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    using tarith = Arith<AlgType>;
+    static constexpr BaseType PI = std::numbers::pi_v<BaseType>;
+
+    bool forward = true;
+
+    private:
+    // Largest (odd) radix with a kernel, cos/sin tables are (R/2)^2 in size
+    static constexpr size_t MAX_HALF_RADIX = 3;
+
+    struct Stage {
+        size_t radix;
+        size_t n; // Length of the transforms produced by this stage
+        size_t stride; // Distance between elements of the same transform
+        StageTwiddles<T> twiddles;
+        std::array<BaseType, MAX_HALF_RADIX * MAX_HALF_RADIX> cs;
+        std::array<BaseType, MAX_HALF_RADIX * MAX_HALF_RADIX> sn;
+        // Strides below OpCapacity only, the twiddle j of element f = stride * p + q at
+        // (j - 1) * (n / radix) * stride + f, see _fradix_lanes
+        Vec<AlgType> lanes;
+
+        Stage(size_t radix, size_t n, size_t stride) : radix(radix), n(n), stride(stride), twiddles(n, radix) {
+            if (stride < tarith::OpCapacity) {
+                size_t count = (n / radix) * stride;
+                lanes = Vec<AlgType>{(radix - 1) * count};
+                for (size_t f = 0; f < count; f++) {
+                    auto factors = twiddles.get(f / stride);
+                    for (size_t j = 1; j < radix; j++) {
+                        lanes.rdata()[(j-1) * count + f] = factors[j-1].re;
+                        lanes.idata()[(j-1) * count + f] = factors[j-1].im;
+                    }
+                }
+            }
+
+            size_t h = radix / 2;
+            for (size_t j = 1; j <= h; j++) {
+                for (size_t k = 1; k <= h; k++) {
+                    BaseType angle = 2.0 * PI * (1.0 * ((j * k) % radix)) / (1.0 * radix);
+                    cs[(j-1) * h + k-1] = std::cos(angle);
+                    sn[(j-1) * h + k-1] = std::sin(angle);
+                }
+            }
+        }
+    };
+
+    size_t _size;
+    std::vector<Stage> stages;
+    mutable Vec<AlgType> work;
+
+    // Radix 4 first, then 2, 3, 5 and 7
+    static std::vector<size_t> factorize(size_t n) {
+        std::vector<size_t> radices;
+        while (n % 4 == 0) {
+            radices.push_back(4);
+            n /= 4;
+        }
+        for (size_t r : {2, 3, 5, 7}) {
+            while (n % r == 0) {
+                radices.push_back(r);
+                n /= r;
+            }
+        }
+        if (n != 1) {
+            radices.clear();
+        }
+        return radices;
+    }
+
+    // With Scaled, every output is also multiplied by scale through the twiddles
+    template <size_t R, bool Inverse, bool Scaled>
+    void _stage_impl(const Stage& stage, MutView<AlgType>& src, MutView<AlgType>& dst, BaseType scale) const noexcept {
+        size_t m = stage.n / R;
+        size_t s = stage.stride;
+        typename tarith::OutputType out[R];
+        typename tarith::InputType in[R];
+        AlgType tw[R];
+
+        if (s < tarith::OpCapacity) {
+            typename tarith::InputType lanes[R];
+            for (size_t k = 0; k < R; k++) {
+                in[k] = src.data() + s * k * m;
+            }
+            for (size_t j = 1; j < R; j++) {
+                size_t offset = (j-1) * m * s;
+                lanes[j-1] = typename tarith::InputType(stage.lanes.rdata() + offset, stage.lanes.idata() + offset);
+            }
+            tarith::template _fradix_lanes<R, Inverse, Scaled>(dst.data(), in, lanes, stage.cs.data(), stage.sn.data(), scale, m * s, s);
+            return;
+        }
+
+        for (size_t p = 0; p < m; p++) {
+            for (size_t k = 0; k < R; k++) {
+                in[k] = src.data() + s * (p + k * m);
+                out[k] = dst.data() + s * (R * p + k);
+            }
+            auto factors = stage.twiddles.get(p);
+            for (size_t j = 1; j < R; j++) {
+                tw[j] = AlgType{factors[j-1].re, Inverse ? -factors[j-1].im : factors[j-1].im};
+                if constexpr (Scaled) {
+                    tw[j] = AlgType{scale * tw[j].re, scale * tw[j].im};
+                }
+            }
+            if constexpr (Scaled) {
+                tw[0] = AlgType{scale, 0.0};
+            }
+            tarith::template _fradix<R, Inverse, Scaled>(out, in, tw, stage.cs.data(), stage.sn.data(), s);
+        }
+    }
+
+    template <bool Inverse, bool Scaled = false>
+    void _stage_dispatch(const Stage& stage, MutView<AlgType>& src, MutView<AlgType>& dst, BaseType scale = 1.0) const noexcept {
+        switch (stage.radix) {
+            case 2: _stage_impl<2, Inverse, Scaled>(stage, src, dst, scale); break;
+            case 3: _stage_impl<3, Inverse, Scaled>(stage, src, dst, scale); break;
+            case 4: _stage_impl<4, Inverse, Scaled>(stage, src, dst, scale); break;
+            case 5: _stage_impl<5, Inverse, Scaled>(stage, src, dst, scale); break;
+            case 7: _stage_impl<7, Inverse, Scaled>(stage, src, dst, scale); break;
+            default: ASSERT(false);
+        }
+    }
+
+    // The last stage has a single butterfly per column (n / radix = 1), which
+    // reads and writes the same positions, so it can always finish in data
+    // The 1/N of the inverse is folded into the twiddles of that stage
+    template <bool Inverse>
+    void _fft_impl(MutView<AlgType>& data) const noexcept {
+        MutView<AlgType> wview(work);
+        MutView<AlgType>* src = &data;
+        MutView<AlgType>* dst = &wview;
+        for (size_t i = 0; i < stages.size(); i++) {
+            if (i + 1 == stages.size()) {
+                dst = &data;
+                if constexpr (Inverse) {
+                    _stage_dispatch<Inverse, true>(stages[i], *src, *dst, BaseType(1.0 / (1.0 * _size)));
+                    break;
+                }
+            }
+            _stage_dispatch<Inverse>(stages[i], *src, *dst);
+            std::swap(src, dst);
+        }
+    }
+
+    public:
+    MixedRadixFFT(size_t N, bool forward = true) : forward(forward), _size(N), work{N} {
+        ASSERT(supports(N));
+        size_t n = N;
+        size_t stride = 1;
+        for (size_t radix : factorize(N)) {
+            stages.emplace_back(radix, n, stride);
+            n /= radix;
+            stride *= radix;
+        }
+    }
+
+    // Whether N only has factors with a dedicated kernel
+    static bool supports(size_t N) noexcept {
+        return N == 1 || (N != 0 && !factorize(N).empty());
+    }
+
+    MutView<AlgType> fft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), _size);
+        _fft_impl<false>(data);
+
+        return input;
+    }
+
+    MutView<AlgType> ifft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), _size);
+        _fft_impl<true>(data);
+
+        return input;
+    }
+
+    MutView<AlgType> operator()(MutView<AlgType> input) const override {
+        if (forward) return fft(std::move(input));
+        else return ifft(std::move(input));
+    }
+
+    size_t input_size() const override {
+        return 1;
+    }
+
+    inline size_t size() const noexcept {
+        return _size;
+    }
+};
+
+template class MixedRadixFFT<double>;
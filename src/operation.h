@@ -58,3 +58,84 @@ inline void altAddSubMultConj(MutType& outa, MutType& outb, const ConstType& c)
     using tarith = Arith<typename MutType::AlgType>;
     tarith::_faltaddsubmultconj(outa.data(), outb.data(), outa.data(), outb.data(), c.data(), outa.size());
 }
+
+// Radix-4 butterfly across four equally sized quarter blocks
+// w1, w2 and w3 hold w^k, w^2k and w^3k respectively
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void quadAddSubProd(MutType& a, MutType& b, MutType& c, MutType& d, 
+        const ConstType& w1, const ConstType& w2, const ConstType& w3) noexcept {
+    ASSERT(a.size() == b.size() && a.size() == c.size() && a.size() == d.size());
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_fquadaddsub_vec(a.data(), b.data(), c.data(), d.data(), a.data(), b.data(), c.data(), d.data(), 
+            w1.data(), w2.data(), w3.data(), a.size());
+}
+
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void quadAddSubMultConj(MutType& a, MutType& b, MutType& c, MutType& d, 
+        const ConstType& w1, const ConstType& w2, const ConstType& w3) noexcept {
+    ASSERT(a.size() == b.size() && a.size() == c.size() && a.size() == d.size());
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_fquadaddsubmultconj(a.data(), b.data(), c.data(), d.data(), a.data(), b.data(), c.data(), d.data(), 
+            w1.data(), w2.data(), w3.data(), a.size());
+}
+
+// Out of place butterfly with a single factor c for the whole range
+// O_a = a + b
+// O_b = (a - b) * c
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void altAddSubMultScalar(MutType& outa, MutType& outb, const ConstType& a, const ConstType& b,
+        const typename Arith<typename MutType::AlgType>::RefType& c) noexcept {
+    ASSERT(outa.size() == outb.size() && outa.size() == a.size() && outa.size() == b.size());
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_faltaddsubmult_scalar(outa.data(), outb.data(), a.data(), b.data(), c, outa.size());
+}
+
+// O_a = a + b
+// O_b = (a - b) * c*
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void altAddSubMultConjScalar(MutType& outa, MutType& outb, const ConstType& a, const ConstType& b,
+        const typename Arith<typename MutType::AlgType>::RefType& c) noexcept {
+    ASSERT(outa.size() == outb.size() && outa.size() == a.size() && outa.size() == b.size());
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_faltaddsubmultconj_scalar(outa.data(), outb.data(), a.data(), b.data(), c, outa.size());
+}
+
+// Radix-4 butterfly across four quarter blocks with a single set of factors for the whole range
+template<typename MutType> requires VecViewType<MutType>
+inline void quadAddSubProdScalar(MutType& a, MutType& b, MutType& c, MutType& d,
+        const typename Arith<typename MutType::AlgType>::RefType& w1, 
+        const typename Arith<typename MutType::AlgType>::RefType& w2, 
+        const typename Arith<typename MutType::AlgType>::RefType& w3) noexcept {
+    ASSERT(a.size() == b.size() && a.size() == c.size() && a.size() == d.size());
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_fquadaddsub_scalar(a.data(), b.data(), c.data(), d.data(), a.data(), b.data(), c.data(), d.data(), 
+            w1, w2, w3, a.size());
+}
+
+// Out of place radix-4 decimation in frequency butterfly with a single set of factors for the whole range
+// O_a = (a + c) + (b + d)
+// O_b = ((a + c) - (b + d)) * w2
+// O_c = ((a - c) - j * (b - d)) * w1
+// O_d = ((a - c) + j * (b - d)) * w3
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void quadAddSubMultScalar(MutType& outa, MutType& outb, MutType& outc, MutType& outd, 
+        const ConstType& a, const ConstType& b, const ConstType& c, const ConstType& d,
+        const typename Arith<typename MutType::AlgType>::RefType& w1, 
+        const typename Arith<typename MutType::AlgType>::RefType& w2, 
+        const typename Arith<typename MutType::AlgType>::RefType& w3) noexcept {
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_fquadaddsubmult_scalar(outa.data(), outb.data(), outc.data(), outd.data(), a.data(), b.data(), c.data(), d.data(),
+            w1, w2, w3, outa.size());
+}
+
+// Conjugate of the above, where -j is replaced with j and every factor is conjugated
+template<typename MutType, typename ConstType> requires VecViewType<MutType> && VecViewType<ConstType>
+inline void quadAddSubMultConjScalar(MutType& outa, MutType& outb, MutType& outc, MutType& outd, 
+        const ConstType& a, const ConstType& b, const ConstType& c, const ConstType& d,
+        const typename Arith<typename MutType::AlgType>::RefType& w1, 
+        const typename Arith<typename MutType::AlgType>::RefType& w2, 
+        const typename Arith<typename MutType::AlgType>::RefType& w3) noexcept {
+    using tarith = Arith<typename MutType::AlgType>;
+    tarith::_fquadaddsubmultconj_scalar(outa.data(), outb.data(), outc.data(), outd.data(), a.data(), b.data(), c.data(), d.data(),
+            w1, w2, w3, outa.size());
+}
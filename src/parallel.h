@@ -0,0 +1,154 @@
+#pragma once
+
+#include "common.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+    // Worker threads kept alive between parallel_for calls, shared by all of them
+    // Starting a thread costs tens of microseconds, more than the smaller layers
+    // of a transform take, so they are only started the first time they are needed
+    //
+    // Every call queues a job of chunks, which the workers and the calling thread take
+    // one at a time. Threads waiting on their own job keep taking chunks of the queued
+    // ones, so that nested calls (the sub transforms of FFTMode::Recursive) cannot deadlock
+    class ThreadPool {
+
+        struct Job {
+            void (*run)(const void* f, size_t i);
+            const void* f;
+            size_t chunks;
+            size_t next; // First chunk not taken yet
+            size_t pending; // Chunks not finished yet
+            std::exception_ptr error;
+        };
+
+        std::mutex lock;
+        std::condition_variable work; // New jobs, for the workers
+        std::condition_variable done; // New jobs and finished ones, for the callers of run()
+        std::vector<Job*> queue;
+        std::vector<std::thread> workers;
+        bool stopping = false;
+
+        // Runs a chunk of the latest job, held must be locked and is locked again on return
+        // The latest job is the innermost one of a nested call, which the others wait on
+        bool _run_chunk(std::unique_lock<std::mutex>& held) {
+            if (queue.empty()) return false;
+            Job* job = queue.back();
+            size_t i = job->next++;
+            if (job->next == job->chunks) {
+                queue.pop_back();
+            }
+
+            held.unlock();
+            std::exception_ptr error;
+            try {
+                job->run(job->f, i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            held.lock();
+
+            if (error && !job->error) {
+                job->error = error;
+            }
+            if (--job->pending == 0) {
+                done.notify_all();
+            }
+            return true;
+        }
+
+        void _work() {
+            std::unique_lock held(lock);
+            while (true) {
+                if (_run_chunk(held)) continue;
+                if (stopping) return;
+                work.wait(held);
+            }
+        }
+
+        public:
+        ThreadPool() = default;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard held(lock);
+                stopping = true;
+            }
+            work.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        static ThreadPool& shared() {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        // Runs f(i) for every i in [0, chunks) on up to chunks threads, the caller being one
+        // of them, and rethrows the first exception of f once all chunks are done
+        // The pool never grows past a worker per core besides the caller's, further
+        // chunks wait for a thread to take them
+        // Throws std::system_error when a missing worker cannot be started
+        template <typename F>
+        void run(size_t chunks, const F& f) {
+            if (chunks == 0) return;
+            Job job{[](const void* p, size_t i) { (*static_cast<const F*>(p))(i); }, &f, chunks, 0, chunks, nullptr};
+            size_t wanted = std::min(chunks, max_threads()) - 1;
+
+            std::unique_lock held(lock);
+            while (workers.size() < wanted) {
+                workers.emplace_back([this]() { _work(); });
+            }
+            queue.push_back(&job);
+            work.notify_all();
+            done.notify_all();
+
+            while (job.pending > 0) {
+                if (!_run_chunk(held)) {
+                    done.wait(held);
+                }
+            }
+            if (job.error) {
+                std::rethrow_exception(job.error);
+            }
+        }
+
+        // Threads a job may run on, the caller included
+        static size_t max_threads() {
+            static const size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            return cores;
+        }
+
+        size_t size() {
+            std::lock_guard held(lock);
+            return workers.size();
+        }
+    };
+
+    // Splits [0, n) into at most threads contiguous chunks and runs f(begin, end)
+    // on each of them, on the threads of ThreadPool::shared() and the calling one
+    // Chunk boundaries are multiples of ALIGNMENT so that SIMD loops never straddle two threads
+    template<size_t ALIGNMENT = 1, typename F>
+    void parallel_for(size_t threads, size_t n, F&& f) {
+        if (n == 0) return;
+        size_t chunk = ceil_align<ALIGNMENT>((n + threads - 1) / std::max<size_t>(threads, 1));
+        if (threads <= 1 || chunk >= n) {
+            f(size_t{0}, n);
+            return;
+        }
+
+        size_t chunks = (n + chunk - 1) / chunk;
+        ThreadPool::shared().run(chunks, [&f, chunk, n](size_t i) {
+            f(i * chunk, std::min(n, (i + 1) * chunk));
+        });
+    }
+}
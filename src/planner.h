@@ -0,0 +1,226 @@
+#pragma once
+
+#include "tview.h"
+#include <common.h>
+#include <fft.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Execution strategy of a power of two FFT
+struct FFTPlan {
+    FFTMode mode = FFTMode::Recursive;
+    size_t shuffle_bits = ShuffleFunction<complex<double>>::DEFAULT_Q;
+    size_t threads = 1;
+
+    bool operator==(const FFTPlan&) const = default;
+};
+
+// Picks the fastest FFTPlan for every size by timing the candidates once
+//
+// The strategy dimensions are tuned one after the other rather than over their
+// full cross product: the butterfly order first, then the COBRA block size, then
+// the thread count, each keeping the best value found for the previous ones.
+// The radix is not a dimension: FFT only has radix-4 layers (with a radix-2 one
+// for odd log2(N)), which make half the passes of radix-2 layers on every size
+//
+// Plans are remembered per size and can be saved to and loaded from a wisdom 
+// file, one plan per line, so that a service only measures a size once:
+//
+//     ctl-wisdom 2 <precision> <backend>
+//     <size> <mode> <shuffle bits> <threads>
+//
+// Where mode is 0 for FFTMode::BreadthFirst and 1 for FFTMode::Recursive
+// Plans measured for another precision or SIMD backend (see header()) are rejected
+template <typename T> requires ScalarType<T>
+class FFTPlanner {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    static constexpr const char* WISDOM_HEADER = "ctl-wisdom 2";
+
+    private:
+    std::map<size_t, FFTPlan> wisdom;
+    size_t max_threads;
+    // Every candidate runs for at least this long
+    std::chrono::nanoseconds min_time;
+
+    // Average time of one forward transform
+    // fft is unitary (FFTNorm::Ortho), so the data stays finite over thousands of them
+    double measure(FFT<T>& fft, MutView<AlgType> data) const {
+        using clock = std::chrono::steady_clock;
+        fft.fft(data); // Warm up the caches and page in the twiddles
+        size_t reps = 0;
+        auto t0 = clock::now();
+        auto t1 = t0;
+        do {
+            fft.fft(data);
+            reps++;
+            t1 = clock::now();
+        } while (t1 - t0 < min_time);
+        return std::chrono::duration<double>(t1 - t0).count() / (1.0 * reps);
+    }
+
+    FFTPlan measure_plan(size_t N) const {
+        Vec<AlgType> data{N};
+        for (size_t i = 0; i < N; i++) {
+            data.rdata()[i] = std::sin(0.01 * i);
+            data.idata()[i] = std::cos(0.03 * i);
+        }
+        MutView<AlgType> view(data.data_ptr(), N);
+
+        // The scaling is folded into the shuffle, timings match the other norms
+        // The twiddle table is built by as many threads as the plans may use
+        FFT<T> fft(N, true, TwiddleMode::Full, max_threads);
+        fft.norm = FFTNorm::Ortho;
+        FFTPlan best;
+        apply(fft, best);
+        double best_time = measure(fft, view);
+
+        auto try_plan = [&](const FFTPlan& candidate) {
+            if (candidate == best) return;
+            apply(fft, candidate);
+            double t = measure(fft, view);
+            if (t < best_time) {
+                best_time = t;
+                best = candidate;
+            }
+        };
+
+        // Both orders are the same below a single recursion block
+        if (N > FFT<T>::RECURSE_BLOCK) {
+            FFTPlan candidate = best;
+            candidate.mode = FFTMode::BreadthFirst;
+            try_plan(candidate);
+        }
+
+        // Block sizes at or above log2(N) / 2 all fall back to plain swaps
+        for (size_t q = 3; q <= 7 && 2 * q < shuffle::num_bits(N); q++) {
+            FFTPlan candidate = best;
+            candidate.shuffle_bits = q;
+            try_plan(candidate);
+        }
+
+        if (N >= FFT<T>::PARALLEL_MIN) {
+            for (size_t t = 2; t <= max_threads; t *= 2) {
+                FFTPlan candidate = best;
+                candidate.threads = t;
+                try_plan(candidate);
+            }
+        }
+
+        return best;
+    }
+
+    public:
+    // max_threads bounds the thread counts tried, defaulting to the available cores
+    FFTPlanner(size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1),
+            std::chrono::nanoseconds min_time = std::chrono::milliseconds(20)) 
+        : max_threads(max_threads), min_time(min_time) {
+    }
+
+    // First line of the wisdom files, the plans only hold for the precision 
+    // and the SIMD backend they were measured with
+    static std::string header() {
+        std::string backend;
+#if __AVX512F__
+        backend = "avx512";
+#elif __AVX2__
+        backend = "avx2";
+#elif SIMD_DISPATCH
+        backend = std::string("dispatch-") + simd::dispatch_target();
+#else
+        backend = "scalar";
+#endif
+        return std::string(WISDOM_HEADER) + " f" + std::to_string(8 * sizeof(T)) + " " + backend;
+    }
+
+    static void apply(FFT<T>& fft, const FFTPlan& plan) {
+        fft.mode = plan.mode;
+        fft.set_shuffle_bits(plan.shuffle_bits);
+        fft.threads = plan.threads;
+    }
+
+    // Plan for a size N transform, measured on the first request for N
+    FFTPlan plan(size_t N) {
+        ASSERT(util::is_pow2(N));
+        auto it = wisdom.find(N);
+        if (it != wisdom.end()) {
+            return it->second;
+        }
+        FFTPlan p = measure_plan(N);
+        wisdom.emplace(N, p);
+        return p;
+    }
+
+    // A FFT object of size N set up with its plan
+    FFT<T> make(size_t N, bool forward = true) {
+        FFT<T> fft(N, forward);
+        apply(fft, plan(N));
+        return fft;
+    }
+
+    bool known(size_t N) const {
+        return wisdom.contains(N);
+    }
+
+    void remember(size_t N, const FFTPlan& p) {
+        wisdom[N] = p;
+    }
+
+    void forget() {
+        wisdom.clear();
+    }
+
+    // Returns false if the file could not be written
+    bool save(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << header() << "\n";
+        for (const auto& [N, p] : wisdom) {
+            out << N << " " << (p.mode == FFTMode::Recursive ? 1 : 0) << " " << p.shuffle_bits << " " << p.threads << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    // Adds the plans of a wisdom file, replacing plans already known for the same sizes
+    // Returns false, without learning anything, if the file is missing, malformed,
+    // measured for another precision or backend, or asks for a block size beyond
+    // ShuffleFunction::max_block_bits() or more threads than there are cores
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+
+        std::string line;
+        if (!std::getline(in, line) || line != header()) return false;
+
+        std::map<size_t, FFTPlan> loaded;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            std::istringstream fields(line);
+            size_t N, mode, bits, threads;
+            if (!(fields >> N >> mode >> bits >> threads)) return false;
+            if (!util::is_pow2(N) || mode > 1) return false;
+            if (bits == 0 || bits > ShuffleFunction<AlgType>::max_block_bits(N)) return false;
+            if (threads == 0 || threads > std::max<size_t>(std::thread::hardware_concurrency(), 1)) return false;
+
+            FFTPlan p;
+            p.mode = (mode == 1) ? FFTMode::Recursive : FFTMode::BreadthFirst;
+            p.shuffle_bits = bits;
+            p.threads = threads;
+            loaded[N] = p;
+        }
+
+        for (const auto& [N, p] : loaded) {
+            wisdom[N] = p;
+        }
+        return true;
+    }
+};
+
+template class FFTPlanner<double>;
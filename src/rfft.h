@@ -0,0 +1,150 @@
+#pragma once
+
+#include "tview.h"
+#include <common.h>
+#include <fft.h>
+#include <cmath>
+#include <numbers>
+
+// FFT of N real samples through a N/2 complex transform
+//
+// The even samples are packed into the real part and the odd samples into
+// the imaginary part, z_n = x_2n + j * x_2n+1. With E and O the transforms
+// of the even and odd samples, Z_k = E_k + j * O_k, and as both are
+// transforms of real data,
+//
+//     E_k = (Z_k + Z*_(N/2-k)) / 2
+//     O_k = (Z_k - Z*_(N/2-k)) / 2j
+//     X_k = E_k + W_N^k * O_k
+//
+// Only the N/2 + 1 non redundant outputs X_0 ... X_N/2 are produced, the
+// rest being X_(N-k) = X*_k. The inverse runs the same steps backwards.
+// The inverse uses an internal workspace of N/2 elements.
+template <typename T> requires ScalarType<T>
+class RFFT {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    static constexpr BaseType PI = std::numbers::pi_v<BaseType>;
+
+    private:
+    size_t _size;
+    FFT<T> half;
+    Vec<AlgType> twiddles; // W_N^k for k in [0, N/4]
+    mutable Vec<AlgType> work;
+
+    public:
+    // N must be a power of two, at least 4
+    RFFT(size_t N) : _size(N), half(N / 2), twiddles{N / 4 + 1}, work{N / 2} {
+        ASSERT(N >= 4 && util::is_pow2(N));
+        for (size_t k = 0; k <= N / 4; k++) {
+            BaseType angle = -2.0 * PI * (1.0 * k) / (1.0 * N);
+            twiddles.rdata()[k] = std::cos(angle);
+            twiddles.idata()[k] = std::sin(angle);
+        }
+    }
+
+    // in holds N real samples, out receives X_0 ... X_N/2
+    MutView<AlgType> fft(ConstView<T> in, MutView<AlgType> out) const {
+        ASSERT(in.size() >= _size && out.size() >= _size / 2 + 1);
+        const size_t h = _size / 2;
+        const BaseType* x = in.data();
+        BaseType* re = out.data().re;
+        BaseType* im = out.data().im;
+
+        for (size_t n = 0; n < h; n++) {
+            re[n] = x[2 * n];
+            im[n] = x[2 * n + 1];
+        }
+
+        half.fft(MutView<AlgType>(out.data(), h));
+
+        // Z_0 = E_0 + j O_0 with both real
+        BaseType z0r = re[0];
+        BaseType z0i = im[0];
+        re[0] = z0r + z0i;
+        im[0] = 0.0;
+        re[h] = z0r - z0i;
+        im[h] = 0.0;
+
+        const BaseType* wr = twiddles.rdata();
+        const BaseType* wi = twiddles.idata();
+        for (size_t k = 1; k <= h / 2; k++) {
+            size_t m = h - k;
+            // E_k = (Z_k + Z*_m) / 2
+            BaseType er = 0.5 * (re[k] + re[m]);
+            BaseType ei = 0.5 * (im[k] - im[m]);
+            // O_k = -j (Z_k - Z*_m) / 2
+            BaseType or_ = 0.5 * (im[k] + im[m]);
+            BaseType oi = -0.5 * (re[k] - re[m]);
+            // W^k O_k
+            BaseType tr = wr[k] * or_ - wi[k] * oi;
+            BaseType ti = wr[k] * oi + wi[k] * or_;
+
+            // X_k = E_k + W^k O_k and X_m = (E_k - W^k O_k)*
+            re[k] = er + tr;
+            im[k] = ei + ti;
+            re[m] = er - tr;
+            im[m] = -(ei - ti);
+        }
+
+        return out;
+    }
+
+    // in holds X_0 ... X_N/2, out receives the N real samples
+    MutView<T> ifft(ConstView<AlgType> in, MutView<T> out) const {
+        ASSERT(in.size() >= _size / 2 + 1 && out.size() >= _size);
+        const size_t h = _size / 2;
+        const BaseType* re = in.data().re;
+        const BaseType* im = in.data().im;
+        BaseType* zr = work.rdata();
+        BaseType* zi = work.idata();
+
+        // The imaginary parts of X_0 and X_N/2 are ignored
+        zr[0] = 0.5 * (re[0] + re[h]);
+        zi[0] = 0.5 * (re[0] - re[h]);
+
+        const BaseType* wr = twiddles.rdata();
+        const BaseType* wi = twiddles.idata();
+        for (size_t k = 1; k <= h / 2; k++) {
+            size_t m = h - k;
+            // E_k = (X_k + X*_m) / 2
+            BaseType er = 0.5 * (re[k] + re[m]);
+            BaseType ei = 0.5 * (im[k] - im[m]);
+            // O_k = W^-k (X_k - X*_m) / 2
+            BaseType dr = 0.5 * (re[k] - re[m]);
+            BaseType di = 0.5 * (im[k] + im[m]);
+            BaseType or_ = wr[k] * dr + wi[k] * di;
+            BaseType oi = wr[k] * di - wi[k] * dr;
+
+            // Z_k = E_k + j O_k and Z_m = E*_k + j O*_k
+            zr[k] = er - oi;
+            zi[k] = ei + or_;
+            zr[m] = er + oi;
+            zi[m] = -ei + or_;
+        }
+
+        half.ifft(MutView<AlgType>(work.data_ptr(), h));
+
+        BaseType* x = out.data();
+        for (size_t n = 0; n < h; n++) {
+            x[2 * n] = zr[n];
+            x[2 * n + 1] = zi[n];
+        }
+
+        return out;
+    }
+
+    // Number of real samples
+    inline size_t size() const noexcept {
+        return _size;
+    }
+
+    // Number of complex outputs, N/2 + 1
+    inline size_t output_size() const noexcept {
+        return _size / 2 + 1;
+    }
+};
+
+template class RFFT<double>;
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include <function.h>
+#include <parallel.h>
 
 namespace revutil {
     static constexpr uint8_t revtable[] = {
@@ -72,8 +73,33 @@ namespace shuffle {
         return bits;
     }
 
+    // The base type of complex numbers, the type itself otherwise
+    template <typename T>
+    struct base_type {
+        using type = T;
+    };
+
+    template <ComplexType T>
+    struct base_type<T> {
+        using type = typename T::BaseType;
+    };
+};
+
+
+// Butterflies carried out on each block while it passes through the COBRA buffer
+// Forward: the first layers of a decimation in time FFT, applied after the blocks are reversed
+// Inverse: the last layers of the matching inverse transform, applied before the blocks are reversed
+enum class ShuffleFusion {
+    None,
+    Forward,
+    Inverse
 };
 
+// Callback of the shuffles and transforms that leaves the data as it is, see FFT::fft()
+struct NoCallback {
+    template <typename View>
+    constexpr void operator()(size_t, View&&) const noexcept {}
+};
 
 // ScalarType is only enforced because the operator() 
 // indexing would break upon usage
@@ -81,12 +107,18 @@ template <typename T> requires ArithType<T>
 class ShuffleFunction : public BaseFunction<T> {
     using RevPair = std::pair<size_t, size_t>;
 
+    public:
+    static constexpr size_t DEFAULT_Q = 5;
+    // Factor the complex shuffles can multiply the elements by
+    using ScaleType = typename shuffle::base_type<T>::type;
+
+    private:
     // Size of a and c addressors -- used for fast shuffler
     // Let it be known that 5 is not a randomly chosen number
     // This number will allow the tmp buffer to be of size 2^(2*Q) = 1024
     // 1024 * 2 * sizeof(double) on x86 will be 16kB, which is half the size of my L1 cache 
     // on my personal desktop, perfect for a wanted swappable temporary buffer
-    const size_t Q = 5;
+    size_t Q = DEFAULT_Q;
 
     std::vector<RevPair> pairs;
     size_t _size;
@@ -95,7 +127,8 @@ class ShuffleFunction : public BaseFunction<T> {
     void generate_pairs() {
         size_t bits = shuffle::num_bits(_size);
         for (size_t i = 0; i < _size; i++) {
-            size_t rev = shuffle::rev_int(i, bits);
+            // rev_int() cannot shift by the whole word
+            size_t rev = (bits == 0) ? i : shuffle::rev_int(i, bits);
             if (i < rev) {
                 // if i == rev, we do not need to switch them anyway so we will
                 // leave them out of this one
@@ -118,13 +151,36 @@ class ShuffleFunction : public BaseFunction<T> {
         using std::swap;
         size_t nbits = shuffle::num_bits(_size);
         for (size_t i = 0; i < _size; i++) {
-            auto ip = shuffle::rev_int(i, nbits);
+            // rev_int() cannot shift by the whole word
+            auto ip = (nbits == 0) ? i : shuffle::rev_int(i, nbits);
             if (i < ip) {
                 swap(input[i], input[ip]);
             }
         }
     }
 
+    // The same swaps, with every element multiplied by scale on its way
+    // Elements that stay in place are scaled as well, so the whole array is still a single pass
+    void shuffle_impl_trivial_scaled(MutView<T>& input, ScaleType scale) const requires ComplexType<T> {
+        auto re = input.data().re;
+        auto im = input.data().im;
+        size_t nbits = shuffle::num_bits(_size);
+        for (size_t i = 0; i < _size; i++) {
+            // rev_int() cannot shift by the whole word
+            auto ip = (nbits == 0) ? i : shuffle::rev_int(i, nbits);
+            if (i < ip) {
+                auto tr = re[i], ti = im[i];
+                re[i] = scale * re[ip];
+                im[i] = scale * im[ip];
+                re[ip] = scale * tr;
+                im[ip] = scale * ti;
+            } else if (i == ip) {
+                re[i] *= scale;
+                im[i] *= scale;
+            }
+        }
+    }
+
     // TODO -- Make this look pretty
     static constexpr int64_t concat(size_t Q, size_t B_SIZE, int64_t a, int64_t b, int64_t c) noexcept {
         return (a << (Q+B_SIZE)) | (b << (Q)) | c;
@@ -140,7 +196,8 @@ class ShuffleFunction : public BaseFunction<T> {
     // Larry Carter and Kang Su Gatlin
     // UC San Diego Department of Computer Science and Engineering
     // https://ieeexplore.ieee.org/document/743505
-    void shuffle_impl_cobra(MutView<T>& input) const {
+    template <typename Load = NoCallback, typename Store = NoCallback>
+    void shuffle_impl_cobra(MutView<T>& input, size_t threads, const Load& load = {}, const Store& store = {}) const {
         // Pseudo code as said in the paper itself is as follows:
         //
         
@@ -157,6 +214,147 @@ class ShuffleFunction : public BaseFunction<T> {
         //          B[c’b’a’] = T[a'c]
 
         size_t nbits = shuffle::num_bits(_size);
+
+        // Each b' line is only ever touched by the iteration of its partner b, 
+        // so the b range can be split between threads with one buffer each
+        util::parallel_for(threads, util::pow2(nbits - 2*Q), [&](size_t b_begin, size_t b_end) {
+            shuffle_impl_cobra_range(input, b_begin, b_end, 1, load, store);
+        });
+    }
+
+    template <ShuffleFusion Fusion, typename Load, typename Store>
+    void shuffle_impl_cobra_fused(MutView<T>& input, size_t threads, ScaleType scale, const Load& load, const Store& store) const {
+        size_t nbits = shuffle::num_bits(_size);
+        util::parallel_for(threads, util::pow2(nbits - 2*Q), [&](size_t b_begin, size_t b_end) {
+            if (fused_layers() == 5) {
+                shuffle_impl_cobra_range<Fusion, 5>(input, b_begin, b_end, scale, load, store);
+            } else {
+                shuffle_impl_cobra_range<Fusion, 3>(input, b_begin, b_end, scale, load, store);
+            }
+        });
+    }
+
+    // Fused butterflies, see ShuffleFusion
+    //
+    // The buffer T[a'c] of a line holds 2^Q element stretches of the input in its rows, 
+    // and stretches of the reversed output in its columns. Each stretch consists of
+    // 2^(Q-F) whole sub transforms of the first F layers, which a codelet computes:
+    // Forward: out[s + r] = DFT(in[s + rev(i)])[r], while the stretch is written out
+    // Inverse: out[s + r] = IDFT(in[s + i])[rev(r)], in the buffer once the stretch is read
+    // As with the layers they replace, the results are unnormalized, unless a scale
+    // is given, which every element is multiplied by as it is written to its final place
+    //
+    // The forward codelets read from the buffer and store straight to the output, which
+    // takes the place of the copy. The inverse ones would have to wait on reads from
+    // memory in the same position, so they instead run in place over the buffer.
+
+    // input[c'b'a'] <-> T[a'c] for a single c, where the stretch from T is transformed
+    template <size_t F>
+    inline void _swap_forward(MutView<T>& input, Vec<T>& tmp, size_t c, size_t b_base, ScaleType scale) const noexcept {
+        using BaseType = typename T::BaseType;
+        constexpr size_t FS = util::pow2(F);
+        constexpr auto rev = codelet::order<FS, true>;
+        BaseType* re = input.data().re;
+        BaseType* im = input.data().im;
+        BaseType* tre = tmp.rdata();
+        BaseType* tim = tmp.idata();
+        T y[FS];
+        for (size_t s = 0; s < util::pow2(Q); s += FS) {
+            auto load = [&](size_t i) {
+                size_t t_index = concat_2(Q, s + rev[i], c);
+                return T{tre[t_index], tim[t_index]};
+            };
+            codelet::dft<carith<T>, FS, false>(y, load);
+            for (size_t r = 0; r < FS; r++) {
+                size_t t_index = concat_2(Q, s + r, c);
+                tre[t_index] = re[b_base + s + r];
+                tim[t_index] = im[b_base + s + r];
+                re[b_base + s + r] = scale * y[r].re;
+                im[b_base + s + r] = scale * y[r].im;
+            }
+        }
+    }
+
+    // input[abc] = T[a'c] for a single a, where the stretch from T is transformed
+    template <size_t F>
+    inline void _store_forward(MutView<T>& input, Vec<T>& tmp, size_t t_base, size_t a_base, ScaleType scale) const noexcept {
+        using BaseType = typename T::BaseType;
+        constexpr size_t FS = util::pow2(F);
+        constexpr auto rev = codelet::order<FS, true>;
+        BaseType* re = input.data().re;
+        BaseType* im = input.data().im;
+        BaseType* tre = tmp.rdata();
+        BaseType* tim = tmp.idata();
+        T y[FS];
+        for (size_t s = 0; s < util::pow2(Q); s += FS) {
+            auto load = [&](size_t i) { return T{tre[t_base + s + rev[i]], tim[t_base + s + rev[i]]}; };
+            codelet::dft<carith<T>, FS, false>(y, load);
+            for (size_t r = 0; r < FS; r++) {
+                re[a_base + s + r] = scale * y[r].re;
+                im[a_base + s + r] = scale * y[r].im;
+            }
+        }
+    }
+
+    // input[c'b'a'] <-> T[a'c] for a single c, where the value leaving T is scaled
+    inline void _swap_inverse(MutView<T>& input, Vec<T>& tmp, size_t c, size_t b_base, ScaleType scale) const noexcept {
+        auto re = input.data().re;
+        auto im = input.data().im;
+        auto tre = tmp.rdata();
+        auto tim = tmp.idata();
+        for (size_t ap = 0; ap < util::pow2(Q); ap++) {
+            size_t t_index = concat_2(Q, ap, c);
+            auto tr = tre[t_index], ti = tim[t_index];
+            tre[t_index] = re[b_base + ap];
+            tim[t_index] = im[b_base + ap];
+            re[b_base + ap] = scale * tr;
+            im[b_base + ap] = scale * ti;
+        }
+    }
+
+    // input[abc] = T[a'c] for a single a, scaled
+    inline void _store_inverse(MutView<T>& input, Vec<T>& tmp, size_t t_base, size_t a_base, ScaleType scale) const noexcept {
+        auto re = input.data().re;
+        auto im = input.data().im;
+        auto tre = tmp.rdata();
+        auto tim = tmp.idata();
+        for (size_t c = 0; c < util::pow2(Q); c++) {
+            re[a_base + c] = scale * tre[t_base + c];
+            im[a_base + c] = scale * tim[t_base + c];
+        }
+    }
+
+    template <size_t F>
+    void _inverse_rows(Vec<T>& tmp) const noexcept {
+        constexpr size_t FS = util::pow2(F);
+        for (size_t p = 0; p < util::pow2(Q); p++) {
+            for (size_t s = 0; s < util::pow2(Q); s += FS) {
+                carith<T>::template _fcodelet<FS, true, true>(tmp.data_ptr() + (concat_2(Q, p, 0) + s), 1, 1);
+            }
+        }
+    }
+
+    // Adjacent columns are consecutive in memory, and are transformed together in SIMD registers
+    template <size_t F>
+    void _inverse_columns(Vec<T>& tmp) const noexcept {
+        constexpr size_t FS = util::pow2(F);
+        for (size_t s = 0; s < util::pow2(Q); s += FS) {
+            carith<T>::template _fcodelet<FS, true, true>(tmp.data_ptr() + concat_2(Q, s, 0), util::pow2(Q), util::pow2(Q));
+        }
+    }
+
+    // The 2^Q elements of input from offset on, the unit the callbacks are called on
+    inline MutView<T> run(MutView<T>& input, size_t offset) const noexcept {
+        return MutView<T>(input.data() + offset, util::pow2(Q));
+    }
+
+    // scale is only read by the fused versions, which are restricted to complex types
+    // load is called on every run of 2^Q input elements before it is read, and store on 
+    // every run of the output once it is written. Both are contiguous in natural order
+    template <ShuffleFusion Fusion = ShuffleFusion::None, size_t F = 0, typename Load = NoCallback, typename Store = NoCallback>
+    void shuffle_impl_cobra_range(MutView<T>& input, size_t b_begin, size_t b_end, [[maybe_unused]] ScaleType scale = 1,
+                                  const Load& load = {}, const Store& store = {}) const {
+        size_t nbits = shuffle::num_bits(_size);
         Vec<T> tmp{util::pow2(2*Q)};
         auto tview = tview::view(tmp);
         // Vec<T> output_copy{input.size()};
@@ -164,13 +362,14 @@ class ShuffleFunction : public BaseFunction<T> {
         
         using std::swap;
 
-        for (uint64_t b = 0; b < util::pow2(nbits - 2*Q); b++) {
+        for (uint64_t b = b_begin; b < b_end; b++) {
             // rev_int() may not be optimized -- be aware of its use
             auto bp = shuffle::rev_int(b, nbits-2*Q);
             if (b > bp) continue; // We have already swapped this 
                                   
             for (uint64_t a = 0; a < util::pow2(Q); a++) {
                 auto ap = shuffle::rev_int(a, Q);
+                load(concat(Q, nbits-2*Q, a, b, 0), run(input, concat(Q, nbits-2*Q, a, b, 0)));
                 for (uint64_t c = 0; c < util::pow2(Q); c++) {
                     // TODO -- make some sick data structure that concats everything for you
                     auto t_index = concat_2(Q, ap, c);
@@ -181,8 +380,26 @@ class ShuffleFunction : public BaseFunction<T> {
                 }
             }
 
+            if constexpr (Fusion == ShuffleFusion::Inverse) {
+                _inverse_rows<F>(tmp);
+            }
+
             for (uint64_t c = 0; c < util::pow2(Q); c++) {
                 auto cp = shuffle::rev_int(c, Q);
+                size_t b_base = concat(Q, nbits-2*Q, cp, bp, 0);
+                // When b = b' the line was loaded above
+                if (b != bp) {
+                    load(b_base, run(input, b_base));
+                }
+                if constexpr (Fusion == ShuffleFusion::Forward) {
+                    _swap_forward<F>(input, tmp, c, b_base, scale);
+                    store(b_base, run(input, b_base));
+                    continue;
+                } else if constexpr (Fusion == ShuffleFusion::Inverse) {
+                    _swap_inverse(input, tmp, c, b_base, scale);
+                    store(b_base, run(input, b_base));
+                    continue;
+                }
                 for (uint64_t ap = 0; ap < util::pow2(Q); ap++) {
                     auto t_index = concat_2(Q, ap, c);
                     auto b_index = concat(Q, nbits-2*Q, cp, bp, ap);
@@ -201,11 +418,26 @@ class ShuffleFunction : public BaseFunction<T> {
 
                     //}
                 }
+                store(b_base, run(input, b_base));
             }
             // Move the swapped data back into the original line by using the same pattern
             if (b != bp) {
+                if constexpr (Fusion == ShuffleFusion::Inverse) {
+                    _inverse_columns<F>(tmp);
+                }
+
                 for (uint64_t a = 0; a < util::pow2(Q); a++) {
                     auto ap = shuffle::rev_int(a, Q);
+                    size_t a_base = concat(Q, nbits-2*Q, a, b, 0);
+                    if constexpr (Fusion == ShuffleFusion::Forward) {
+                        _store_forward<F>(input, tmp, concat_2(Q, ap, 0), a_base, scale);
+                        store(a_base, run(input, a_base));
+                        continue;
+                    } else if constexpr (Fusion == ShuffleFusion::Inverse) {
+                        _store_inverse(input, tmp, concat_2(Q, ap, 0), a_base, scale);
+                        store(a_base, run(input, a_base));
+                        continue;
+                    }
                     for (uint64_t c = 0; c < util::pow2(Q); c++) {
                         // TODO -- make some sick data structure that concats everything for you
                         auto t_index = concat_2(Q, ap, c);
@@ -214,6 +446,7 @@ class ShuffleFunction : public BaseFunction<T> {
                         // T[a'c] = a[abc]
                         input[a_index] = tview[t_index];
                     }
+                    store(a_base, run(input, a_base));
                 }
 
             }
@@ -225,30 +458,204 @@ class ShuffleFunction : public BaseFunction<T> {
         // }
     }
 
+    // Out of place versions, out[i] = scale * in[rev(i)], or in[-rev(i) mod N] when negate is set
+    // Nothing is swapped, so the input is only ever read
+
+    void shuffle_impl_copy_trivial(const ConstView<T>& in, MutView<T>& out, ScaleType scale, bool negate) const {
+        auto re = in.data().re;
+        auto im = in.data().im;
+        size_t nbits = shuffle::num_bits(_size);
+        size_t mask = _size - 1;
+        for (size_t i = 0; i < _size; i++) {
+            // rev_int() cannot shift by the whole word
+            size_t ip = (nbits == 0) ? i : shuffle::rev_int(i, nbits);
+            size_t src = negate ? ((_size - ip) & mask) : ip;
+            out.data().re[i] = scale * re[src];
+            out.data().im[i] = scale * im[src];
+        }
+    }
+
+    // Every line b is read into the buffer once, transposed as T[c a'] = in[abc],
+    // so that out[c'b'a'] is a row of the buffer, and the stores are those of _store_forward
+    // F = 0 is a plain copy
+    template <size_t F>
+    void shuffle_impl_copy_cobra_range(const ConstView<T>& in, MutView<T>& out, size_t b_begin, size_t b_end, 
+                                       ScaleType scale, bool negate) const {
+        size_t nbits = shuffle::num_bits(_size);
+        size_t mask = _size - 1;
+        Vec<T> tmp{util::pow2(2*Q)};
+        auto tre = tmp.rdata();
+        auto tim = tmp.idata();
+        auto re = in.data().re;
+        auto im = in.data().im;
+
+        for (uint64_t b = b_begin; b < b_end; b++) {
+            auto bp = shuffle::rev_int(b, nbits-2*Q);
+            for (uint64_t a = 0; a < util::pow2(Q); a++) {
+                auto ap = shuffle::rev_int(a, Q);
+                // The rows of out are only written, without the prefetch every store would
+                // wait on the line to be read in. Row (a, b') receives the line of c' = a
+                for (size_t k = 0; k < util::pow2(Q); k += 64 / sizeof(ScaleType)) {
+                    __builtin_prefetch(out.data().re + concat(Q, nbits-2*Q, a, bp, k), 1);
+                    __builtin_prefetch(out.data().im + concat(Q, nbits-2*Q, a, bp, k), 1);
+                }
+                for (uint64_t c = 0; c < util::pow2(Q); c++) {
+                    size_t a_index = concat(Q, nbits-2*Q, a, b, c);
+                    size_t src = negate ? ((_size - a_index) & mask) : a_index;
+                    tre[concat_2(Q, c, ap)] = re[src];
+                    tim[concat_2(Q, c, ap)] = im[src];
+                }
+            }
+
+            for (uint64_t c = 0; c < util::pow2(Q); c++) {
+                auto cp = shuffle::rev_int(c, Q);
+                size_t t_base = concat_2(Q, c, 0);
+                size_t b_base = concat(Q, nbits-2*Q, cp, bp, 0);
+                if constexpr (F > 0) {
+                    _store_forward<F>(out, tmp, t_base, b_base, scale);
+                } else {
+                    for (uint64_t ap = 0; ap < util::pow2(Q); ap++) {
+                        out.data().re[b_base + ap] = scale * tre[t_base + ap];
+                        out.data().im[b_base + ap] = scale * tim[t_base + ap];
+                    }
+                }
+            }
+        }
+    }
+
+    template <size_t F>
+    void shuffle_impl_copy_cobra(const ConstView<T>& in, MutView<T>& out, size_t threads, ScaleType scale, bool negate) const {
+        size_t nbits = shuffle::num_bits(_size);
+        // Lines are no longer swapped in pairs, each one is independent
+        util::parallel_for(threads, util::pow2(nbits - 2*Q), [&](size_t b_begin, size_t b_end) {
+            shuffle_impl_copy_cobra_range<F>(in, out, b_begin, b_end, scale, negate);
+        });
+    }
+
     public:
-    ShuffleFunction(size_t n) : _size(n) {
+    ShuffleFunction(size_t n, size_t q = DEFAULT_Q) : Q(q), _size(n) {
         ASSERT(util::is_pow2(n));
         ASSERT(n >= 1);
+        ASSERT(q >= 1);
         // pairs.reserve(n / 2);
         // generate_pairs();
     }
 
     MutView<T> operator()(MutView<T> input) const override {
+        return operator()(input, 1);
+    }
+
+    MutView<T> operator()(MutView<T> input, size_t threads) const {
         // shuffle_impl(input);
         if (_size <= util::pow2(2*Q)) {
             // shuffle_impl(input);
             shuffle_impl_trivial(input);
         } else {
-            shuffle_impl_cobra(input);
+            shuffle_impl_cobra(input, threads);
         }
         
         return input;
     }
 
+    // Shuffles with fused_layers() butterfly layers folded in, see ShuffleFusion
+    // The caller is responsible for the remaining layers
+    //
+    // Every element is also multiplied by scale, for free on the fused and swap paths.
+    // Only the unfused COBRA path (block_bits() < 3) needs a separate pass for it
+    //
+    // load and store take the callbacks of FFT::fft(), load on the input before it is 
+    // read and store on the output once it is written. The COBRA paths call them on runs of
+    // 2^Q elements as the runs pass through, the swap path on the whole array, which fits in cache
+    template <typename Load = NoCallback, typename Store = NoCallback>
+    MutView<T> operator()(MutView<T> input, size_t threads, ShuffleFusion fusion, ScaleType scale = 1.0,
+                          const Load& load = {}, const Store& store = {}) const requires ComplexType<T> {
+        if (_size <= util::pow2(2*Q)) {
+            MutView<T> data(input.data(), _size);
+            load(0, data);
+            if (scale == 1.0) {
+                shuffle_impl_trivial(data);
+            } else {
+                shuffle_impl_trivial_scaled(data, scale);
+            }
+            store(0, data);
+            return input;
+        }
+
+        if (fused_layers() == 0 || fusion == ShuffleFusion::None) {
+            if (scale == 1.0) {
+                shuffle_impl_cobra(input, threads, load, store);
+                return input;
+            }
+
+            shuffle_impl_cobra(input, threads, load);
+            T mult{scale, 0.0};
+            util::parallel_for<Arith<T>::OpCapacity>(threads, _size, [&](size_t begin, size_t end) {
+                MutView<T> part(input.data() + begin, end - begin);
+                part *= mult;
+                store(begin, part);
+            });
+            return input;
+        }
+
+        if (fusion == ShuffleFusion::Forward) {
+            shuffle_impl_cobra_fused<ShuffleFusion::Forward>(input, threads, scale, load, store);
+        } else {
+            shuffle_impl_cobra_fused<ShuffleFusion::Inverse>(input, threads, scale, load, store);
+        }
+        return input;
+    }
+
+    // Out of place shuffle from in into out, see the in place version above for fusion and scale
+    // Only the forward layers can be fused, as the inverse ones come after the reversal
+    //
+    // With negate, in is read at -rev(i) mod N. The forward layers then compute the
+    // unnormalized inverse transform, as sum x[-n] W^nk = sum x[n] W^-nk
+    // in and out must not overlap
+    MutView<T> operator()(const ConstView<T>& in, MutView<T> out, size_t threads, ShuffleFusion fusion, 
+                          ScaleType scale = 1.0, bool negate = false) const requires ComplexType<T> {
+        ASSERT(fusion != ShuffleFusion::Inverse);
+        ASSERT(in.size() >= _size && out.size() >= _size);
+        if (_size <= util::pow2(2*Q)) {
+            shuffle_impl_copy_trivial(in, out, scale, negate);
+        } else if (fused_layers() == 0 || fusion == ShuffleFusion::None) {
+            shuffle_impl_copy_cobra<0>(in, out, threads, scale, negate);
+        } else if (fused_layers() == 5) {
+            shuffle_impl_copy_cobra<5>(in, out, threads, scale, negate);
+        } else {
+            shuffle_impl_copy_cobra<3>(in, out, threads, scale, negate);
+        }
+        return out;
+    }
+
+    // Number of butterfly layers a fused shuffle carries out, 5 or 3 depending on the block size
+    // Only the COBRA path fuses layers, smaller sizes are swapped in place
+    // Every depth is a separate set of codelets, so only two are compiled
+    inline size_t fused_layers() const noexcept {
+        if (_size <= util::pow2(2*Q) || Q < 3) return 0;
+        return (Q >= 5) ? 5 : 3;
+    }
+
     inline size_t size() const noexcept {
         return _size;
     }
 
+    // Number of bits in the a and c addressors of COBRA, the buffer holds 2^(2*q) elements
+    // Sizes up to 2^(2*q) are shuffled by plain swaps instead
+    inline void set_block_bits(size_t q) noexcept {
+        ASSERT(q >= 1 && q <= max_block_bits(_size));
+        Q = q;
+    }
+
+    // Largest block size accepted for size n, beyond log2(n) / 2 all sizes are swapped 
+    // and the buffer only grows
+    static constexpr size_t max_block_bits(size_t n) noexcept {
+        return std::max(DEFAULT_Q, shuffle::num_bits(n) / 2);
+    }
+
+    inline size_t block_bits() const noexcept {
+        return Q;
+    }
+
     size_t input_size() const override {
         return 1;
     }
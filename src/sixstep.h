@@ -0,0 +1,187 @@
+#pragma once
+
+#include "operation.h"
+#include "tview.h"
+#include <common.h>
+#include <function.h>
+#include <fft.h>
+#include <parallel.h>
+#include <transpose.h>
+#include <cmath>
+#include <numbers>
+
+// Bailey's six step FFT for transforms that do not fit in cache
+//
+// With N = N1 * N2, n = N2 * n1 + n2 and k = k1 + N1 * k2, the DFT splits into
+//
+//     X_k = sum_n2 W_N2^(n2 k2) * [W_N^(n2 k1) * sum_n1 x_n * W_N1^(n1 k1)]
+//
+// Which is carried out as
+//     1. Transpose the N1 x N2 input so that the n1 sequences become rows
+//     2. N2 row transforms of length N1
+//     3. Multiply by the twiddle factors W_N^(n2 k1)
+//     4. Transpose back, so that the n2 sequences become rows
+//     5. N1 row transforms of length N2
+//     6. Transpose, placing the outputs in natural order
+//
+// Every row fits in cache, so the data only goes to memory once per transpose
+// and row pass rather than once per butterfly layer. When log2(N) is even the
+// matrix is square and all transposes are in place, otherwise N1 = 2 * N2 and the
+// transposes go through an internal workspace of N elements.
+template <typename T> requires ScalarType<T>
+class SixStepFFT : public BaseFunction<complex<T>> {
+
+    public:
+    using BaseType = T;
+    using AlgType = complex<T>;
+    static constexpr BaseType PI = std::numbers::pi_v<BaseType>;
+
+    bool forward = true;
+    // Number of threads the rows and transposes are split between
+    size_t threads = 1;
+
+    private:
+    size_t _size;
+    size_t n1; // Length of the first row transforms
+    size_t n2; // Length of the second row transforms
+    FFT<T> fft1;
+    FFT<T> fft2;
+    // W_N^e for e = hi * N1 + lo is coarse[hi] * fine[lo]
+    // Keeps the twiddle tables at O(sqrt(N)) while staying accurate
+    Vec<AlgType> fine; // W_N^lo for lo in [0, N1)
+    Vec<AlgType> coarse; // W_N2^hi for hi in [0, N2)
+    mutable Vec<AlgType> work;
+
+    static Vec<AlgType> make_roots(size_t n, size_t N) {
+        Vec<AlgType> roots{n};
+        for (size_t i = 0; i < n; i++) {
+            BaseType angle = -2.0 * PI * (1.0 * i) / (1.0 * N);
+            roots.rdata()[i] = std::cos(angle);
+            roots.idata()[i] = std::sin(angle);
+        }
+        return roots;
+    }
+
+    bool square() const noexcept {
+        return n1 == n2;
+    }
+
+    // Fills tw with W_N^(n2 * k1) for k1 in [0, N1), conjugated for the inverse
+    void _row_twiddles(BaseType* tr, BaseType* ti, size_t row, bool inverse) const noexcept {
+        const BaseType* fr = fine.rdata();
+        const BaseType* fi = fine.idata();
+        const BaseType* cr = coarse.rdata();
+        const BaseType* ci = coarse.idata();
+        BaseType sign = inverse ? -1.0 : 1.0;
+        size_t shift = shuffle::num_bits(n1);
+        for (size_t k = 0; k < n1; k++) {
+            size_t e = row * k;
+            size_t hi = e >> shift, lo = e & (n1 - 1);
+            tr[k] = cr[hi] * fr[lo] - ci[hi] * fi[lo];
+            ti[k] = sign * (cr[hi] * fi[lo] + ci[hi] * fr[lo]);
+        }
+    }
+
+    void _fft_impl(MutView<AlgType>& data, bool inverse) const {
+        size_t nthreads = std::max<size_t>(threads, 1);
+        auto ptr = data.data();
+        auto wptr = work.data_ptr();
+        auto cptr = [](complexptr<T> p) { return ccomplexptr<T>{p.re, p.im}; };
+
+        // 1. n1 sequences become the rows of an N2 x N1 matrix
+        complexptr<T> a = ptr;
+        if (square()) {
+            transpose::square_inplace(ptr, n1, nthreads);
+        } else {
+            transpose::blocked(cptr(ptr), wptr, n1, n2, nthreads);
+            a = wptr;
+        }
+
+        // 2 and 3. Row transforms, followed by the twiddles while the row is still in cache
+        util::parallel_for(nthreads, n2, [&](size_t begin, size_t end) {
+            Vec<AlgType> tw{n1};
+            ConstView<AlgType> twview(tw);
+            for (size_t r = begin; r < end; r++) {
+                MutView<AlgType> row(a + r * n1, n1);
+                if (inverse) {
+                    fft1.ifft(row);
+                } else {
+                    fft1.fft(row);
+                }
+                if (r != 0) {
+                    _row_twiddles(tw.rdata(), tw.idata(), r, inverse);
+                    row *= twview;
+                }
+            }
+        });
+
+        // 4. n2 sequences become the rows of an N1 x N2 matrix
+        if (square()) {
+            transpose::square_inplace(ptr, n1, nthreads);
+        } else {
+            transpose::blocked(cptr(wptr), ptr, n2, n1, nthreads);
+        }
+
+        // 5. Row transforms, out of place into the workspace when there is one, 
+        // so that the last transpose writes the output straight to data
+        complexptr<T> b = square() ? ptr : wptr;
+        util::parallel_for(nthreads, n1, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                ConstView<AlgType> in(cptr(ptr + r * n2), n2);
+                MutView<AlgType> row(b + r * n2, n2);
+                if (inverse) {
+                    fft2.ifft(in, row);
+                } else {
+                    fft2.fft(in, row);
+                }
+            }
+        });
+
+        // 6. Natural order output
+        if (square()) {
+            transpose::square_inplace(ptr, n1, nthreads);
+        } else {
+            transpose::blocked(cptr(wptr), ptr, n1, n2, nthreads);
+        }
+    }
+
+    public:
+    // N must be a power of two, at least 16 so that every row fills a SIMD register
+    SixStepFFT(size_t N, bool forward = true) : 
+        forward(forward), _size(N),
+        n1(util::pow2((shuffle::num_bits(N) + 1) / 2)), n2(N / n1),
+        fft1(n1), fft2(n2), fine(make_roots(n1, N)), coarse(make_roots(n2, n2)),
+        work(square() ? Vec<AlgType>{} : Vec<AlgType>{N}) {
+        ASSERT(util::is_pow2(N) && N >= 16);
+    }
+
+    MutView<AlgType> fft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), _size);
+        _fft_impl(data, false);
+
+        return input;
+    }
+
+    // The row inverses scale by 1/N1 and 1/N2, which is 1/N overall
+    MutView<AlgType> ifft(MutView<AlgType> input) const {
+        MutView<AlgType> data(input.data(), _size);
+        _fft_impl(data, true);
+
+        return input;
+    }
+
+    MutView<AlgType> operator()(MutView<AlgType> input) const override {
+        if (forward) return fft(std::move(input));
+        else return ifft(std::move(input));
+    }
+
+    size_t input_size() const override {
+        return 1;
+    }
+
+    inline size_t size() const noexcept {
+        return _size;
+    }
+};
+
+template class SixStepFFT<double>;
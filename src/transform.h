@@ -98,9 +98,9 @@ class FourierDual {
     FuncPtr transform_time_func(const SumFunction<AlgType>& u) {
         auto addend_time = u.get_addend();
         FFT<T> fft(addend_time.size());
-        auto data = addend_time.make_copy();
+        Vec<AlgType> data{addend_time.size()};
 
-        fft(tview::view(data));
+        fft.fft(addend_time, tview::view(data));
 
         return std::make_shared<SumFunction<complex<T>>>(data);
     }
@@ -130,10 +130,11 @@ class FourierDual {
         // Vec<complex<T>> prods{_size};
         auto comp = std::make_shared<CompositeFunction<AlgType>>();
 
-        auto kernel = u.get_multiplicand().make_copy();
+        auto multiplicand = u.get_multiplicand();
+        Vec<AlgType> kernel{multiplicand.size()};
 
-        FFT<T> fft(kernel.size());
-        fft.fft(kernel);
+        FFT<T> fft(multiplicand.size());
+        fft.fft(multiplicand, tview::view(kernel));
 
         auto conv = std::make_shared<ConvolutionFunction<AlgType>>(kernel);
         
@@ -151,9 +152,9 @@ class FourierDual {
     FuncPtr transform_freq_func(const SumFunction<AlgType>& v) {
         auto addend_freq = v.get_addend();
         FFT<T> fft(addend_freq.size());
-        auto data = addend_freq.make_copy();
+        Vec<AlgType> data{addend_freq.size()};
 
-        fft.ifft(tview::view(data));
+        fft.ifft(addend_freq, tview::view(data));
         return std::make_shared<SumFunction<complex<T>>>(data);
     }
 
@@ -174,12 +175,13 @@ class FourierDual {
     FuncPtr transform_freq_func(const ProductFunction<AlgType>& v) {
         auto comp = std::make_shared<CompositeFunction<AlgType>>();
 
-        auto kernel = v.get_multiplicand().make_copy();
+        auto multiplicand = v.get_multiplicand();
+        Vec<AlgType> kernel{multiplicand.size()};
 
         // We need an ifft with a operator() default...
-        auto ifft = FFT<T>(kernel.size());
+        auto ifft = FFT<T>(multiplicand.size());
 
-        ifft.ifft(kernel);
+        ifft.ifft(multiplicand, tview::view(kernel));
 
         auto conv = std::make_shared<ConvolutionFunction<AlgType>>(kernel);
 
@@ -3,10 +3,30 @@
 #include "common.h"
 #include <vec.h>
 #include <tview.h>
+#include <parallel.h>
 #include <cmath>
 #include <numbers>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
+// Storage of the twiddle factors of large transforms
+// Full: every layer is stored, 3N/2 factors for a transform of size N
+// Compact: only the layers up to TwiddleTable::COMPACT_FULL are stored whole, the larger 
+// ones only keep their first octant (about N/4 factors in all). The rest of those layers 
+// is derived from the octant by swapping and negating, a block at a time, as the butterflies 
+// need it. The derived factors are the same as the stored ones, bit for bit
+enum class TwiddleMode {
+    Full,
+    Compact
+};
+
 // The storage class of twiddles factors!
 // While counterintuitive, we will store twiddle factors in this
 // manner. Lets take the example of N = 8. We should therefore
@@ -21,26 +41,170 @@
 //
 // This pattern allows easy access to contiguous data locations
 // at the expense of more space taken up
+//
+// The radix-4 butterflies additionally need w^3k for the first quarter
+// of each layer. Those are kept in a second store in the same fashion,
+// where a layer of size n holds n/4 factors starting at index n/4
+//
+// [1]: w0
+// [2]: w0 w3
+//
+// In compact mode the store stops at COMPACT_FULL, the larger layers are read through
+// load_layer / load_cube_layer, which derive them from their octant (see TwiddleMode)
+//
+// A table is filled by its constructor and never modified afterwards
 template <typename T> requires FloatingType<T>
-class TwiddleStore {
+class TwiddleTable {
     public:
     using AlgType = complex<T>;
     static constexpr T PI = std::numbers::pi_v<T>;
     
+    // Largest layer stored by a compact table
+    // The sub transforms up to that size are computed in cache (see FFT::RECURSE_BLOCK),
+    // where reading their factors is cheap, and reuse them many times
+    static constexpr size_t COMPACT_FULL = util::pow2(14);
+
     private:
-    // Member is static so that holders may share this variable 
-    static Vec<AlgType> hold;
-    static size_t ref_count;
+    Vec<AlgType> hold;
+    Vec<AlgType> cube_hold;
+    // w^k for k in [0, n/8] of the layers of size n above the stored ones, indexed by log2(n)
+    std::vector<Vec<AlgType>> octants;
+    size_t _size;
+    size_t _stored;
+    size_t _build_threads;
+
+    // Layers at least this large are filled by the threads given to the constructor
+    static constexpr size_t PARALLEL_MIN = util::pow2(16);
+    // Distance between the anchors of the last layer, see fill_last_layer
+    static constexpr size_t ANCHOR_STRIDE = 64;
+
+    static constexpr size_t stored_size(size_t n, TwiddleMode mode) noexcept {
+        return (mode == TwiddleMode::Compact) ? std::min(n, COMPACT_FULL) : n;
+    }
+
+    size_t _threads(size_t lsize) const noexcept {
+        return lsize >= PARALLEL_MIN ? _build_threads : 1;
+    }
+
+    // Writes the images of w^k = c - is, k in [0, n/8], in each octant of the layer
+    // The octants are half open, [0, n/8), [n/8, n/4), [n/4, 3n/8), [3n/8, n/2)
+    void put_octant(T* re, T* im, size_t n, size_t k, double c, double s) {
+        if (k < n / 8) {
+            re[k] = c;          im[k] = -s;
+            re[n/4 + k] = -s;   im[n/4 + k] = -c;
+        }
+        if (k > 0) {
+            re[n/4 - k] = s;    im[n/4 - k] = -c;
+            re[n/2 - k] = -c;   im[n/2 - k] = -s;
+        }
+    }
+
+    // Calls put(k, c, s) with w^k = c - is for k in [0, n/8], n >= 8
+    // Within the octant, w^(a + j) = w^a * w^j where the anchors w^a are ANCHOR_STRIDE 
+    // apart. Both w^a and w^j come straight from std::cos / std::sin, so the error of 
+    // the product stays within a few ulps, unlike a running recurrence. Everything is 
+    // computed in double and only rounded to T when stored
+    template <typename F>
+    void for_octant(size_t n, F&& put) {
+        std::array<double, ANCHOR_STRIDE> jc, js;
+        for (size_t j = 0; j < ANCHOR_STRIDE; j++) {
+            double angle = 2.0 * std::numbers::pi * j / (1.0 * n);
+            jc[j] = std::cos(angle);
+            js[j] = std::sin(angle);
+        }
 
+        util::parallel_for<ANCHOR_STRIDE>(_threads(n), n / 8 + 1, [&](size_t begin, size_t end) {
+            for (size_t a = begin; a < end; a += ANCHOR_STRIDE) {
+                double angle = 2.0 * std::numbers::pi * a / (1.0 * n);
+                double ac = std::cos(angle);
+                double as = std::sin(angle);
+                for (size_t j = 0; j < std::min(ANCHOR_STRIDE, end - a); j++) {
+                    put(a + j, ac * jc[j] - as * js[j], as * jc[j] + ac * js[j]);
+                }
+            }
+        });
+    }
+
+    // Only the first octant is evaluated, the rest of the layer follows from the symmetries
+    // of the sine and cosine
     void fill_last_layer(size_t n) {
         T* re = &hold.rdata()[n / 2];
         T* im = &hold.idata()[n / 2];
+        if (n < 8) {
+            for (size_t k = 0; k < n / 2; k++) {
+                double angle = 2.0 * std::numbers::pi * (-1.0 * k) / (1.0 * n);
+                re[k] = std::cos(angle); 
+                im[k] = std::sin(angle); 
+            }
+            return;
+        }
+
+        for_octant(n, [&](size_t k, double c, double s) {
+            put_octant(re, im, n, k, c, s);
+        });
+    }
+
+    // Compact tables evaluate the octant of the largest layer, and subsample it for the
+    // smaller ones, as fill_layer does. The largest layer they store is derived from the octants
+    void fill_compact_layers(size_t n) {
+        octants.resize(std::countr_zero(n) + 1);
+        octants[std::countr_zero(n)] = Vec<AlgType>{n / 8 + 1};
+        T* re = octants[std::countr_zero(n)].rdata();
+        T* im = octants[std::countr_zero(n)].idata();
+        for_octant(n, [&](size_t k, double c, double s) {
+            re[k] = c;
+            im[k] = -s;
+        });
+
+        for (size_t lsize = n / 2; lsize > _stored; lsize /= 2) {
+            auto& oct = octants[std::countr_zero(lsize)];
+            const auto& super = octants[std::countr_zero(lsize) + 1];
+            oct = Vec<AlgType>{lsize / 8 + 1};
+            for (size_t k = 0; k <= lsize / 8; k++) {
+                oct.rdata()[k] = super.rdata()[2*k];
+                oct.idata()[k] = super.idata()[2*k];
+            }
+        }
+
+        util::parallel_for(_threads(_stored), _stored / 2, [&](size_t begin, size_t end) {
+            derive<2>(2 * _stored, 2 * begin, end - begin, &hold.rdata()[_stored / 2 + begin], &hold.idata()[_stored / 2 + begin], 1);
+        });
+    }
+
+    // Writes sign * w^q for q = q0 + i * DQ, i in [0, count), of the layer of size n, every q in [0, n/2)
+    // The octants are split as in put_octant, each one a single pass over the octant of the layer
+    // DQ is a constant for the loops to be vectorized
+    template <size_t DQ>
+    void derive(size_t n, size_t q0, size_t count, T* re, T* im, T sign) const noexcept {
+        const T* ore = octants[std::countr_zero(n)].rdata();
+        const T* oim = octants[std::countr_zero(n)].idata();
+        size_t o = n / 8;
+        // First i whose q reaches bound
+        auto until = [&](size_t bound) {
+            return (bound <= q0) ? size_t{0} : std::min(count, (bound - q0 + DQ - 1) / DQ);
+        };
 
-        for (size_t k = 0; k < n / 2; k++) {
-            T angle = 2.0 * PI * (-1.0 * k) / (1.0 * n);
-            re[k] = std::cos(angle); 
-            im[k] = std::sin(angle); 
-        }        
+        size_t i = 0;
+        for (size_t end = until(o); i < end; i++) {
+            size_t r = q0 + i * DQ;
+            re[i] = sign * ore[r];
+            im[i] = sign * oim[r];
+        }
+        for (size_t end = until(2 * o); i < end; i++) {
+            size_t r = 2 * o - (q0 + i * DQ);
+            re[i] = -sign * oim[r];
+            im[i] = -sign * ore[r];
+        }
+        for (size_t end = until(3 * o); i < end; i++) {
+            size_t r = q0 + i * DQ - 2 * o;
+            re[i] = sign * oim[r];
+            im[i] = -sign * ore[r];
+        }
+        for (; i < count; i++) {
+            size_t r = 4 * o - (q0 + i * DQ);
+            re[i] = -sign * ore[r];
+            im[i] = sign * oim[r];
+        }
     }
 
     void fill_layer(size_t lsize) {
@@ -50,57 +214,298 @@ class TwiddleStore {
         T* rsuper = &hold.rdata()[lsize];
         T* isuper = &hold.idata()[lsize];
 
-        for (size_t i = 0; i < lsize / 2; i++) {
-            re[i] = rsuper[2*i];
-            im[i] = isuper[2*i];
-        }
+        util::parallel_for(_threads(lsize), lsize / 2, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                re[i] = rsuper[2*i];
+                im[i] = isuper[2*i];
+            }
+        });
+    }
+
+    // w^3k is read from the last layer, reduced by w^(n/2) = -1 past its end
+    void fill_last_cube_layer(size_t n) {
+        T* re = &cube_hold.rdata()[n / 4];
+        T* im = &cube_hold.idata()[n / 4];
+
+        const T* rlast = &hold.rdata()[n / 2];
+        const T* ilast = &hold.idata()[n / 2];
+
+        util::parallel_for(_threads(n), n / 4, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                size_t m = 3 * k;
+                if (m < n / 2) {
+                    re[k] = rlast[m];
+                    im[k] = ilast[m];
+                } else {
+                    re[k] = -rlast[m - n / 2];
+                    im[k] = -ilast[m - n / 2];
+                }
+            }
+        });
+    }
+
+    void fill_cube_layer(size_t lsize) {
+        T* re = &cube_hold.rdata()[lsize / 4];
+        T* im = &cube_hold.idata()[lsize / 4];
+
+        T* rsuper = &cube_hold.rdata()[lsize / 2];
+        T* isuper = &cube_hold.idata()[lsize / 2];
+
+        util::parallel_for(_threads(lsize), lsize / 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                re[i] = rsuper[2*i];
+                im[i] = isuper[2*i];
+            }
+        });
     }
 
     void fill_layers(size_t n) {
-        fill_last_layer(n);
-        for (size_t lsize = n / 2; lsize != 0; lsize /= 2) {
+        if (_stored < n) {
+            fill_compact_layers(n);
+        } else {
+            fill_last_layer(n);
+        }
+        for (size_t lsize = _stored / 2; lsize != 0; lsize /= 2) {
             fill_layer(lsize);
         }
+
+        if (_stored < 4) return;
+        fill_last_cube_layer(_stored);
+        for (size_t lsize = _stored / 2; lsize >= 4; lsize /= 2) {
+            fill_cube_layer(lsize);
+        }
+    }
+
+    public:
+    // The table is filled by up to threads threads, the calling one included,
+    // capped to the number of hardware threads
+    TwiddleTable(size_t n, TwiddleMode mode = TwiddleMode::Full, size_t threads = 1) : 
+        hold{stored_size(n, mode)}, cube_hold{std::max<size_t>(stored_size(n, mode) / 2, 1)}, 
+        _size(n), _stored(stored_size(n, mode)),
+        _build_threads(std::clamp<size_t>(threads, 1, std::max<size_t>(std::thread::hardware_concurrency(), 1))) {
+        ASSERT(util::is_pow2(n));
+        fill_layers(n);
+    }
+
+    TwiddleTable(const TwiddleTable&) = delete;
+    TwiddleTable& operator=(const TwiddleTable&) = delete;
+
+    // Largest layer held
+    size_t size() const noexcept {
+        return _size;
+    }
+
+    // Largest layer that get_layer and get_cube_layer can return
+    size_t stored() const noexcept {
+        return _stored;
+    }
+
+    // Gets the layer with n twiddle factors
+    // n must be a power of 2 and less than or equal to the stored size
+    ConstView<complex<T>> get_layer(size_t n) const {
+        ASSERT(util::is_pow2(n) && n <= _stored);
+        return ConstView<complex<T>>(hold, n / 2, n / 2);
+    }
+
+    // Gets the w^3k factors for the first quarter of the layer with n twiddle factors
+    // n must be a power of 2 greater than or equal to 4
+    ConstView<complex<T>> get_cube_layer(size_t n) const {
+        ASSERT(util::is_pow2(n) && n >= 4 && n <= _stored);
+        return ConstView<complex<T>>(cube_hold, n / 4, n / 4);
+    }
+
+    // Writes the factors [lo, lo + out.size()) of the layer with n twiddle factors to out
+    // Works for every layer up to size(), stored or not
+    void load_layer(size_t n, size_t lo, MutView<complex<T>> out) const {
+        ASSERT(util::is_pow2(n) && n <= _size && lo + out.size() <= n / 2);
+        if (n <= _stored) {
+            std::copy_n(hold.rdata() + n / 2 + lo, out.size(), out.data().re);
+            std::copy_n(hold.idata() + n / 2 + lo, out.size(), out.data().im);
+            return;
+        }
+        derive<1>(n, lo, out.size(), out.data().re, out.data().im, 1);
+    }
+
+    // Same as load_layer, for the factors of get_cube_layer
+    void load_cube_layer(size_t n, size_t lo, MutView<complex<T>> out) const {
+        ASSERT(util::is_pow2(n) && n >= 4 && n <= _size && lo + out.size() <= n / 4);
+        if (n <= _stored) {
+            std::copy_n(cube_hold.rdata() + n / 4 + lo, out.size(), out.data().re);
+            std::copy_n(cube_hold.idata() + n / 4 + lo, out.size(), out.data().im);
+            return;
+        }
+        // w^3k for 3k past n/2 is -w^(3k - n/2)
+        size_t hi = lo + out.size();
+        size_t wrap = std::clamp<size_t>((n / 2 + 2) / 3, lo, hi);
+        derive<3>(n, 3 * lo, wrap - lo, out.data().re, out.data().im, 1);
+        derive<3>(n, 3 * wrap - n / 2, hi - wrap, out.data().re + (wrap - lo), out.data().im + (wrap - lo), -1);
+    }
+};
+
+// Process wide twiddle tables, one per size and precision
+//
+// Tables up to TwiddleTable::COMPACT_FULL are kept for the rest of the process. Each power 
+// of two has a slot holding an atomic pointer to its table, looking a table up only loads 
+// those pointers, and the lock is only taken by the first request of a size, which builds 
+// and publishes the table. Published tables are never modified nor freed, so the views 
+// handed out stay valid whichever FFTs are created or destroyed on other threads in the 
+// meantime. With 3n/2 factors for a size n, all of them together hold less than 
+// 3 * COMPACT_FULL factors, 768kB in double precision
+//
+// Larger tables would pin hundreds of MB after a single large transform, so they are 
+// owned by the TwiddleStores using them and freed along with the last one. The registry
+// only keeps weak references to them, which are looked up under the lock
+//
+// A table holds every layer below its size, so a request is served by the smallest
+// live table that is large enough. Large full and compact tables have their own slots,
+// compact requests small enough to be stored whole use the full ones
+//
+// threads only applies to the request that builds the table, the others find it built
+template <typename T> requires FloatingType<T>
+class TwiddleRegistry {
+    static constexpr size_t SLOTS = 8 * sizeof(size_t);
+    static constexpr size_t KEPT_SLOTS = std::countr_zero(TwiddleTable<T>::COMPACT_FULL) + 1;
+
+    static std::array<std::atomic<const TwiddleTable<T>*>, KEPT_SLOTS> kept;
+    static std::array<std::array<std::weak_ptr<const TwiddleTable<T>>, SLOTS>, 2> shared;
+    static std::mutex build_lock;
+
+    // A reference to a kept table, which owns nothing
+    static std::shared_ptr<const TwiddleTable<T>> _unowned(const TwiddleTable<T>* table) {
+        return std::shared_ptr<const TwiddleTable<T>>(std::shared_ptr<void>(), table);
     }
 
-    void allocate(size_t n) {
-        if (this->ref_count == 0 || n >= hold.size()) {
-            this->hold = Vec<AlgType>{n};
-            fill_layers(n);
+    static std::shared_ptr<const TwiddleTable<T>> _get_kept(size_t bits, size_t threads) {
+        for (size_t b = bits; b < KEPT_SLOTS; b++) {
+            if (auto table = kept[b].load(std::memory_order_acquire)) {
+                return _unowned(table);
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(build_lock);
+        // Another thread may have built it while this one waited
+        if (auto table = kept[bits].load(std::memory_order_acquire)) {
+            return _unowned(table);
         }
-        this->ref_count++;
+        auto table = new TwiddleTable<T>(util::pow2(bits), TwiddleMode::Full, threads);
+        kept[bits].store(table, std::memory_order_release);
+        return _unowned(table);
     }
 
-    void deallocate() {
-        this->ref_count--;
-        if (this->ref_count == 0) {
-            this->hold.~Vec();
+    public:
+    static std::shared_ptr<const TwiddleTable<T>> get(size_t n, TwiddleMode mode = TwiddleMode::Full, size_t threads = 1) {
+        ASSERT(util::is_pow2(n));
+        size_t bits = std::countr_zero(n);
+        if (n <= TwiddleTable<T>::COMPACT_FULL) {
+            return _get_kept(bits, threads);
         }
+
+        auto& slots = shared[static_cast<size_t>(mode)];
+        std::lock_guard<std::mutex> guard(build_lock);
+        for (size_t b = bits; b < SLOTS; b++) {
+            if (auto table = slots[b].lock()) {
+                return table;
+            }
+        }
+        auto table = std::make_shared<const TwiddleTable<T>>(n, mode, threads);
+        slots[bits] = table;
+        return table;
     }
+};
+
+template <typename T> requires FloatingType<T>
+std::array<std::atomic<const TwiddleTable<T>*>, TwiddleRegistry<T>::KEPT_SLOTS> TwiddleRegistry<T>::kept{};
+
+template <typename T> requires FloatingType<T>
+std::array<std::array<std::weak_ptr<const TwiddleTable<T>>, TwiddleRegistry<T>::SLOTS>, 2> TwiddleRegistry<T>::shared{};
+
+template <typename T> requires FloatingType<T>
+std::mutex TwiddleRegistry<T>::build_lock;
 
+// The twiddles of a transform of size n, a handle to a table of the registry
+// Copies are free, and any number of threads may read the same table
+template <typename T> requires FloatingType<T>
+class TwiddleStore {
     public:
-    TwiddleStore(size_t n) {
-        // Query for second half of Vec
-        // Do operations on that
+    using AlgType = complex<T>;
+    static constexpr T PI = std::numbers::pi_v<T>;
+
+    private:
+    std::shared_ptr<const TwiddleTable<T>> table;
+
+    public:
+    // threads is the number of threads that may build the table, see TwiddleRegistry
+    TwiddleStore(size_t n, TwiddleMode mode = TwiddleMode::Full, size_t threads = 1) : 
+        table(TwiddleRegistry<T>::get(n, mode, threads)) {
         ASSERT(util::is_pow2(n));
-        allocate(n);
+    }
+
+    // Largest layer that get_layer and get_cube_layer can return, 
+    // the layers above it must be read through load_layer and load_cube_layer
+    size_t stored() const noexcept {
+        return table->stored();
     }
 
     // Gets the layer with n twiddle factors
-    // n must be a power of 2 and less than or equal to the precomputed size
+    // n must be a power of 2 and less than or equal to the stored size
     ConstView<complex<T>> get_layer(size_t n) const {
-        ASSERT(util::is_pow2(n));
-        return ConstView<complex<T>>(hold, n / 2, n / 2);
+        return table->get_layer(n);
+    }
+
+    // Gets the w^3k factors for the first quarter of the layer with n twiddle factors
+    // n must be a power of 2 greater than or equal to 4
+    ConstView<complex<T>> get_cube_layer(size_t n) const {
+        return table->get_cube_layer(n);
     }
 
-    ~TwiddleStore() {
-        deallocate();
+    // Writes the factors [lo, lo + out.size()) of the layer with n twiddle factors to out
+    void load_layer(size_t n, size_t lo, MutView<complex<T>> out) const {
+        table->load_layer(n, lo, out);
+    }
+
+    // Writes the factors [lo, lo + out.size()) of the cube layer with n twiddle factors to out
+    void load_cube_layer(size_t n, size_t lo, MutView<complex<T>> out) const {
+        table->load_cube_layer(n, lo, out);
     }
 };
 
 
+// Twiddle factors of a single stage of a mixed radix transform
+// A stage of radix r combines r sub transforms of length n / r into
+// transforms of length n, which needs W_n^(jp) for j in [1, r) and p in [0, n/r)
+// The factors of the same p are kept adjacent, since a butterfly uses all of them at once
+//
+// Ex: n = 6, r = 3
+// [0]: w0 w0 (p = 0)
+// [2]: w1 w2 (p = 1)
 template <typename T> requires FloatingType<T>
-size_t TwiddleStore<T>::ref_count = 0;
+class StageTwiddles {
+    public:
+    using AlgType = complex<T>;
+    static constexpr T PI = std::numbers::pi_v<T>;
 
-template <typename T> requires FloatingType<T>
-Vec<complex<T>> TwiddleStore<T>::hold;
+    private:
+    Vec<AlgType> hold;
+    size_t _radix;
+
+    public:
+    StageTwiddles(size_t n, size_t radix) : hold{std::max<size_t>((n / radix) * (radix - 1), 1)}, _radix(radix) {
+        ASSERT(n % radix == 0);
+        T* re = hold.rdata();
+        T* im = hold.idata();
+        for (size_t p = 0; p < n / radix; p++) {
+            for (size_t j = 1; j < radix; j++) {
+                // Reduce jp before converting to keep the angle accurate for large n
+                T angle = 2.0 * PI * (-1.0 * ((j * p) % n)) / (1.0 * n);
+                re[p * (radix - 1) + j - 1] = std::cos(angle);
+                im[p * (radix - 1) + j - 1] = std::sin(angle);
+            }
+        }
+    }
+
+    // The radix - 1 factors W_n^(jp), j in [1, radix)
+    ConstView<AlgType> get(size_t p) const {
+        size_t offset = p * (_radix - 1);
+        return ConstView<AlgType>(ccomplexptr<T>{hold.rdata() + offset, hold.idata() + offset}, _radix - 1);
+    }
+};
@@ -206,14 +206,14 @@ class Vec<complex<T>> : public BaseNumVec<T> {
     public:
     Vec(std::initializer_list<size_t> init) : BaseNumVec<T>(generate_base(init)) {
         // Use default constructor, then move new one into it
-        std::array<size_t, MAX_DIMS> base_dims;
+        std::array<size_t, BASE_MAX_DIMS> base_dims;
 
         base_dims[0] = 2; // One dimension for real, one for imaginary
         uint32_t i = 1;
         // TODO -- multiply subsequent dimensions to find out 
         // the correct aligment for this
         for (auto d : init) {
-            ASSERT(i < MAX_DIMS);
+            ASSERT(i < BASE_MAX_DIMS);
             base_dims[i] = d;
             i++;
         }
@@ -26,8 +26,9 @@ UTEST(ArithTests, TestDoubles) {
 }
 
 UTEST(ArithTests, TestFloats) {
-    float a[128];
-    float b[128];
+    using farith = arith<float>;
+    alignas(farith::Alignment) float a[128];
+    alignas(farith::Alignment) float b[128];
     for (int i = 0; i < 127; i++) {
         a[i] = 1.0 * i;
         b[i] = 1.0 * i;
@@ -46,3 +47,37 @@ UTEST(ArithTests, TestFloats) {
     // Don't look at first index, it is a victim of dividing by 0
     for (int i = 1; i < 127; i++) EXPECT_TRUE(tutil::deq(a[i], 1.0 * i));
 }
+
+// Ranges that do not fill the last register must leave the memory past them untouched
+UTEST(ArithTests, TestComplexFloatTails) {
+    using tarith = carith<complex<float>>;
+    constexpr size_t N = 19;
+    alignas(tarith::Alignment) float re[32];
+    alignas(tarith::Alignment) float im[32];
+    alignas(tarith::Alignment) float wre[32];
+    alignas(tarith::Alignment) float wim[32];
+    for (size_t i = 0; i < 32; i++) {
+        re[i] = 1.0f * i;
+        im[i] = -1.0f * i;
+        wre[i] = 0.5f;
+        wim[i] = 2.0f;
+    }
+
+    complexptr<float> a{re, im};
+    complexptr<float> b{re + 20, im + 20};
+    ccomplexptr<float> w{wre, wim};
+    tarith::_mul_vec(a, a, w, N);
+    for (size_t i = 0; i < 32; i++) {
+        float r = (i < N) ? 0.5f * i + 2.0f * i : 1.0f * i;
+        float m = (i < N) ? 2.0f * i - 0.5f * i : -1.0f * i;
+        EXPECT_TRUE(tutil::eq(re[i], r));
+        EXPECT_TRUE(tutil::eq(im[i], m));
+    }
+
+    // Shorter than a register, starting halfway through one
+    tarith::_add_vec(b, b, w, 3);
+    for (size_t i = N; i < 32; i++) {
+        EXPECT_TRUE(tutil::eq(re[i], (i >= 20 && i < 23) ? 1.0f * i + 0.5f : 1.0f * i));
+        EXPECT_TRUE(tutil::eq(im[i], (i >= 20 && i < 23) ? -1.0f * i + 2.0f : -1.0f * i));
+    }
+}
@@ -0,0 +1,70 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <batchfft.h>
+
+UTEST(BatchFFTTests, TestMatchesFFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // A count that leaves a partial group, and a size past the vertical limit
+    const size_t count = 13;
+    for (size_t size : {1, 2, 4, 8, 16, 32, 64, 512, 1024, 4096}) {
+        BatchFFT<double> batch(size);
+        FFT<double> fft(size);
+        Vec<complex<double>> x{count * size};
+        Vec<complex<double>> y{count * size};
+        for (size_t i = 0; i < count * size; i++) {
+            x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+            x.idata()[i] = y.idata()[i] = ampgen(engine);
+        }
+        auto orig = x;
+
+        batch.fft(x, count);
+        bool same = true;
+        for (size_t s = 0; s < count; s++) {
+            MutView<complex<double>> row(y.data_ptr() + s * size, size);
+            fft.fft(row);
+        }
+        auto xview = tview::view(x);
+        auto yview = tview::view(y);
+        for (size_t i = 0; i < count * size; i++) {
+            same = same && tutil::eq(xview[i], yview[i]);
+        }
+        EXPECT_TRUE(same);
+
+        batch.ifft(x, count);
+        auto oview = tview::view(orig);
+        for (size_t i = 0; i < count * size; i++) {
+            same = same && tutil::eq(xview[i], oview[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(BatchFFTTests, TestRowsOfVec) {
+    const size_t rows = 8;
+    const size_t size = 64;
+    BatchFFT<double> batch(size);
+    Vec<complex<double>> x{rows, size};
+    EXPECT_EQ(x.stride(), size);
+
+    // Row s holds an impulse at s, so its transform is W_size^(s * k)
+    x.zero();
+    for (size_t s = 0; s < rows; s++) {
+        x.rdata()[s * size + s] = 1.0;
+    }
+    batch.fft(x);
+
+    auto xview = tview::view(x);
+    bool same = true;
+    for (size_t s = 0; s < rows; s++) {
+        for (size_t k = 0; k < size; k++) {
+            double angle = -2.0 * std::numbers::pi * (1.0 * ((s * k) % size)) / (1.0 * size);
+            same = same && tutil::eq(xview[s * size + k].re, cos(angle)) && tutil::eq(xview[s * size + k].im, sin(angle));
+        }
+    }
+    EXPECT_TRUE(same);
+}
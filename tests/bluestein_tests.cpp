@@ -0,0 +1,73 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <bluestein.h>
+
+UTEST(BluesteinTests, TestAgainstDFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Primes, prime multiples and a few sizes the other transforms already handle
+    for (size_t size : {1, 2, 3, 11, 13, 64, 97, 143, 1009, 2 * 1013}) {
+        BluesteinFFT<double> fft(size);
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> orig{size};
+
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = orig.rdata()[i] = ampgen(engine);
+            x.idata()[i] = orig.idata()[i] = ampgen(engine);
+        }
+
+        auto s = fft(x);
+
+        EXPECT_TRUE(tutil::random_check<complex<double>>(s.data(), size, [&orig, size](size_t k) {
+            complex<double> sum{0.0, 0.0};
+            for (size_t n = 0; n < size; n++) {
+                double angle = -2.0 * std::numbers::pi * (1.0 * ((k * n) % size)) / (1.0 * size);
+                sum.re += orig.rdata()[n] * cos(angle) - orig.idata()[n] * sin(angle);
+                sum.im += orig.rdata()[n] * sin(angle) + orig.idata()[n] * cos(angle);
+            }
+            return sum;
+        }));
+
+        s = fft.ifft(s);
+        EXPECT_TRUE(tutil::random_eq(s.data(), tview::view(orig).data(), size));
+    }
+}
+
+UTEST(BluesteinTests, TestSharedTables) {
+    BluesteinFFT<double> a(97);
+    BluesteinFFT<double> b(97, false);
+    EXPECT_EQ(BluesteinRegistry<double>::get(97).get(), BluesteinRegistry<double>::get(97).get());
+    EXPECT_NE(BluesteinRegistry<double>::get(97).get(), BluesteinRegistry<double>::get(101).get());
+
+    Vec<complex<double>> x{97};
+    Vec<complex<double>> orig{97};
+    for (size_t i = 0; i < 97; i++) {
+        x.rdata()[i] = orig.rdata()[i] = 1.0 * i;
+        x.idata()[i] = orig.idata()[i] = -0.5 * i;
+    }
+
+    b(a(x));
+    EXPECT_TRUE(tutil::random_eq(tview::view(x).data(), tview::view(orig).data(), 97));
+
+    // The transforms keep their tables once the registry lets go of them
+    BluesteinRegistry<double>::clear();
+    b(a(x));
+    EXPECT_TRUE(tutil::random_eq(tview::view(x).data(), tview::view(orig).data(), 97));
+}
+
+UTEST(BluesteinTests, TestLargeTablesReleased) {
+    // Tables above KEPT_MAX are shared while in use, and freed with their last user
+    const size_t n = BluesteinRegistry<double>::KEPT_MAX + 1;
+    std::weak_ptr<const BluesteinTable<double>> table;
+    {
+        BluesteinFFT<double> a(n);
+        BluesteinFFT<double> b(n, false);
+        table = BluesteinRegistry<double>::get(n);
+        EXPECT_EQ(BluesteinRegistry<double>::get(n).get(), table.lock().get());
+    }
+    EXPECT_TRUE(table.expired());
+}
@@ -1,6 +1,7 @@
 #include <utest.h>
 #include "test_utils.h"
 #include <convolve.h>
+#include <random>
 
 UTEST(ConvolutionTests, SimpleConvolution) {
     size_t SIZE = 32;
@@ -25,3 +26,174 @@ UTEST(ConvolutionTests, SimpleConvolution) {
     }));
 
 }
+
+UTEST(ConvolutionTests, MatchesDirectConvolution) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-1.0, 1.0);
+
+    // Sizes on both sides of RECURSE_BLOCK, with odd and even numbers of layers
+    for (size_t size : {size_t{1}, size_t{2}, size_t{8}, size_t{64}, util::pow2(15), util::pow2(16)}) {
+        for (auto mode : {FFTMode::Recursive, FFTMode::BreadthFirst}) {
+            Vec<complex<double>> x{size};
+            Vec<complex<double>> h{size};
+            for (size_t i = 0; i < size; i++) {
+                x.rdata()[i] = ampgen(engine);
+                x.idata()[i] = ampgen(engine);
+                h.rdata()[i] = ampgen(engine);
+                h.idata()[i] = ampgen(engine);
+            }
+            auto xo = x;
+            auto ho = h;
+
+            FFT<double> fft(size);
+            fft.mode = mode;
+            fft.convolution_kernel(tview::view(h));
+            fft.convolve(tview::view(x), ConstView<complex<double>>(h));
+
+            EXPECT_TRUE(tutil::random_check<cplx128_t>(tview::view(x).data(), size, [&](size_t i) {
+                cplx128_t sum{0.0, 0.0};
+                for (size_t j = 0; j < size; j++) {
+                    size_t k = (i + size - j) % size;
+                    sum.re += xo.rdata()[j] * ho.rdata()[k] - xo.idata()[j] * ho.idata()[k];
+                    sum.im += xo.rdata()[j] * ho.idata()[k] + xo.idata()[j] * ho.rdata()[k];
+                }
+                return sum;
+            }));
+        }
+    }
+}
+
+UTEST(ConvolutionTests, LinearMatchesDirectConvolution) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-1.0, 1.0);
+
+    // Kernels shorter and longer than the input, in one block or several
+    std::pair<size_t, size_t> cases[] = {{1, 1}, {5, 3}, {3, 5}, {100, 1}, {1000, 17}, {5000, 300}, {300, 5000}};
+    for (auto [L, M] : cases) {
+        Vec<complex<double>> x{L};
+        Vec<complex<double>> h{M};
+        for (size_t i = 0; i < L; i++) {
+            x.rdata()[i] = ampgen(engine);
+            x.idata()[i] = ampgen(engine);
+        }
+        for (size_t i = 0; i < M; i++) {
+            h.rdata()[i] = ampgen(engine);
+            h.idata()[i] = ampgen(engine);
+        }
+
+        auto full = [&](size_t n) {
+            cplx128_t sum{0.0, 0.0};
+            for (size_t k = 0; k < M; k++) {
+                if (k > n || n - k >= L) continue;
+                size_t j = n - k;
+                sum.re += x.rdata()[j] * h.rdata()[k] - x.idata()[j] * h.idata()[k];
+                sum.im += x.rdata()[j] * h.idata()[k] + x.idata()[j] * h.rdata()[k];
+            }
+            return sum;
+        };
+
+        std::tuple<ConvMode, size_t, size_t> modes[] = {
+            {ConvMode::Full, 0, L + M - 1},
+            {ConvMode::Same, (std::min(L, M) - 1) / 2, std::max(L, M)},
+            {ConvMode::Valid, std::min(L, M) - 1, std::max(L, M) - std::min(L, M) + 1}};
+        for (size_t hint : {size_t{0}, L}) {
+            LinearConvolution<complex<double>> conv(ConstView<complex<double>>(h, 0, M), hint);
+            for (auto [mode, start, len] : modes) {
+                EXPECT_EQ(conv.output_size(L, mode), len);
+                Vec<complex<double>> y{len};
+                conv(ConstView<complex<double>>(x, 0, L), tview::view(y), mode);
+                EXPECT_TRUE(tutil::random_check<cplx128_t>(tview::view(y).data(), len, [&](size_t i) {
+                    return full(start + i);
+                }));
+            }
+        }
+    }
+}
+
+UTEST(ConvolutionTests, StreamingMatchesLinear) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-1.0, 1.0);
+    std::uniform_int_distribution<size_t> chunkgen(1, 700);
+
+    const size_t L = 20000;
+    Vec<complex<double>> x{L};
+    for (size_t i = 0; i < L; i++) {
+        x.rdata()[i] = ampgen(engine);
+        x.idata()[i] = ampgen(engine);
+    }
+
+    for (size_t M : {size_t{1}, size_t{33}, size_t{1000}}) {
+        Vec<complex<double>> h{M};
+        for (size_t i = 0; i < M; i++) {
+            h.rdata()[i] = ampgen(engine);
+            h.idata()[i] = ampgen(engine);
+        }
+        ConstView<complex<double>> hview(h, 0, M);
+        LinearConvolution<complex<double>> linear(hview);
+        Vec<complex<double>> expected{L + M - 1};
+        linear(ConstView<complex<double>>(x, 0, L), tview::view(expected));
+
+        // The default block size and the smallest one for the kernel
+        size_t small = std::max<size_t>(4, Arith<complex<double>>::OpCapacity);
+        while (small < M) small *= 2;
+        for (size_t block : {size_t{0}, small}) {
+            StreamingConvolution<complex<double>> stream(hview, block);
+            size_t delay = stream.latency();
+            Vec<complex<double>> y{L};
+            // Twice, to check reset(), the second time in place
+            for (int pass = 0; pass < 2; pass++) {
+                if (pass == 1) {
+                    stream.reset();
+                    std::memcpy(y.rdata(), x.rdata(), sizeof(double) * L);
+                    std::memcpy(y.idata(), x.idata(), sizeof(double) * L);
+                }
+                for (size_t done = 0; done < L; ) {
+                    size_t n = std::min(chunkgen(engine), L - done);
+                    MutView<complex<double>> out(y.data_ptr() + done, n);
+                    ConstView<complex<double>> in = (pass == 0) ? ConstView<complex<double>>(x, done, n) : ConstView<complex<double>>(y, done, n);
+                    stream(in, out);
+                    done += n;
+                }
+
+                EXPECT_TRUE(tutil::random_check<cplx128_t>(tview::view(y).data(), L, [&](size_t i) {
+                    if (i < delay) return cplx128_t{0.0, 0.0};
+                    return cplx128_t{expected.rdata()[i - delay], expected.idata()[i - delay]};
+                }));
+            }
+        }
+    }
+}
+
+UTEST(ConvolutionTests, StreamingMaxLatency) {
+    Vec<complex<double>> h{1000};
+    h.zero();
+    h.rdata()[999] = 1.0;
+
+    // The largest block within the bound, or the smallest one when none is
+    for (size_t M : {size_t{1}, size_t{33}, size_t{1000}}) {
+        ConstView<complex<double>> hview(h, 0, M);
+        size_t unbounded = StreamingConvolution<complex<double>>(hview).latency();
+        for (size_t bound : {size_t{64}, size_t{1500}, size_t{5000}}) {
+            StreamingConvolution<complex<double>> stream(hview, 0, bound);
+            size_t smallest = util::fft_size<Arith<complex<double>>::OpCapacity>(M);
+            if (stream.block_size() > smallest) {
+                EXPECT_LE(stream.latency(), bound);
+                EXPECT_TRUE(2 * stream.block_size() - M + 1 > bound || stream.latency() == unbounded);
+            } else {
+                EXPECT_EQ(stream.block_size(), smallest);
+            }
+        }
+    }
+
+    // A delayed impulse comes out latency() + M - 1 samples late
+    const size_t M = 1000;
+    StreamingConvolution<complex<double>> stream(ConstView<complex<double>>(h, 0, M), 0, 1500);
+    Vec<complex<double>> x{4096};
+    x.zero();
+    x.rdata()[0] = 1.0;
+    stream(ConstView<complex<double>>(x, 0, 4096), tview::view(x));
+    EXPECT_TRUE(tutil::eq(tview::view(x)[stream.latency() + M - 1], cplx128_t{1.0, 0.0}));
+}
@@ -129,5 +129,415 @@ UTEST(FFTTests, TestIFFT) {
     EXPECT_TRUE(tutil::random_check<cplx128_t>(s.data(), s.size(), [](size_t i) {
         return cplx128_t{1.0 * i, 2.0 * i};
     }));
-    
+
+    // A single point is its own transform, and its shuffle swaps nothing
+    FFT<double> single(1);
+    Vec<complex<double>> y{1};
+    y.rdata()[0] = 3.0;
+    y.idata()[0] = -2.0;
+    single.ifft(single.fft(y));
+    EXPECT_TRUE(tutil::eq(tview::view(y)[0], cplx128_t{3.0, -2.0}));
+}
+
+UTEST(FFTTests, TestRadix4AgainstDFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Covers both even and odd numbers of layers
+    for (size_t size = 2; size <= 512; size *= 2) {
+        FFT<double> fft(size);
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> orig{size};
+
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = orig.rdata()[i] = ampgen(engine);
+            x.idata()[i] = orig.idata()[i] = ampgen(engine);
+        }
+
+        auto s = fft(x);
+
+        EXPECT_TRUE(tutil::random_check<complex<double>>(s.data(), size, [&orig, size](size_t k) {
+            complex<double> sum{0.0, 0.0};
+            for (size_t n = 0; n < size; n++) {
+                double angle = -2.0 * std::numbers::pi * (1.0 * ((k * n) % size)) / (1.0 * size);
+                sum.re += orig.rdata()[n] * cos(angle) - orig.idata()[n] * sin(angle);
+                sum.im += orig.rdata()[n] * sin(angle) + orig.idata()[n] * cos(angle);
+            }
+            return sum;
+        }));
+
+        s = fft.ifft(s);
+        EXPECT_TRUE(tutil::random_eq(s.data(), tview::view(orig).data(), size));
+    }
+}
+
+UTEST(FFTTests, TestRecursiveMatchesBreadthFirst) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Sizes above the recursion block, with odd and even numbers of layers
+    for (size_t size : {FFT<double>::RECURSE_BLOCK * 2, FFT<double>::RECURSE_BLOCK * 4}) {
+        FFT<double> recursive(size);
+        FFT<double> layered(size);
+        recursive.mode = FFTMode::Recursive;
+        layered.mode = FFTMode::BreadthFirst;
+
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> y{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+            x.idata()[i] = y.idata()[i] = ampgen(engine);
+        }
+        auto orig = x;
+
+        auto rs = recursive.fft(x);
+        auto ls = layered.fft(y);
+        EXPECT_TRUE(tutil::random_eq(rs.data(), ls.data(), size));
+
+        rs = recursive.ifft(rs);
+        EXPECT_TRUE(tutil::random_eq(rs.data(), tview::view(orig).data(), size));
+    }
+}
+
+UTEST(FFTTests, TestThreadedMatchesSerial) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Thread counts that do and do not divide the sub transforms evenly
+    for (size_t size : {FFT<double>::RECURSE_BLOCK * 2, FFT<double>::RECURSE_BLOCK * 4}) {
+        for (FFTMode mode : {FFTMode::Recursive, FFTMode::BreadthFirst}) {
+            for (size_t threads : {2, 3, 4}) {
+                FFT<double> serial(size);
+                FFT<double> threaded(size);
+                serial.mode = threaded.mode = mode;
+                threaded.threads = threads;
+
+                Vec<complex<double>> x{size};
+                Vec<complex<double>> y{size};
+                for (size_t i = 0; i < size; i++) {
+                    x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+                    x.idata()[i] = y.idata()[i] = ampgen(engine);
+                }
+                auto orig = x;
+
+                auto ss = serial.fft(x);
+                auto ts = threaded.fft(y);
+                bool same = true;
+                for (size_t i = 0; i < size; i++) {
+                    same = same && tutil::eq(ss[i], ts[i]);
+                }
+                EXPECT_TRUE(same);
+
+                ts = threaded.ifft(ts);
+                auto oview = tview::view(orig);
+                for (size_t i = 0; i < size; i++) {
+                    same = same && tutil::eq(ts[i], oview[i]);
+                }
+                EXPECT_TRUE(same);
+            }
+        }
+    }
+}
+
+UTEST(FFTTests, TestShuffleBlockSizes) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    const size_t size = 1 << 16;
+    FFT<double> reference(size);
+    Vec<complex<double>> x{size};
+    for (size_t i = 0; i < size; i++) {
+        x.rdata()[i] = ampgen(engine);
+        x.idata()[i] = ampgen(engine);
+    }
+    auto expected = x;
+    reference.fft(expected);
+    auto eview = tview::view(expected);
+
+    for (size_t q : {3, 4, 6, 7, 8}) {
+        FFT<double> fft(size);
+        fft.set_shuffle_bits(q);
+        EXPECT_EQ(fft.shuffle_bits(), q);
+        auto y = x;
+        auto s = fft.fft(y);
+        bool same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && tutil::eq(s[i], eview[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(FFTTests, TestNormalization) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Swapped, unfused COBRA and both depths of the fused COBRA shuffles
+    // The last size is large enough to be split between threads
+    std::pair<size_t, size_t> cases[] = {{1, 5}, {64, 5}, {256, 2}, {1024, 3}, {1 << 12, 5}, {1 << 15, 2}};
+    for (auto [size, q] : cases) {
+        Vec<complex<double>> x{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = ampgen(engine);
+            x.idata()[i] = ampgen(engine);
+        }
+        FFT<double> reference(size);
+        reference.norm = FFTNorm::None;
+        auto expected = x;
+        reference.fft(expected);
+        auto eview = tview::view(expected);
+        auto xview = tview::view(x);
+
+        double n = 1.0 * size;
+        // Forward and inverse scale of each mode
+        std::tuple<FFTNorm, double, double> modes[] = {
+            {FFTNorm::Backward, 1.0, 1.0 / n}, {FFTNorm::Forward, 1.0 / n, 1.0},
+            {FFTNorm::Ortho, 1.0 / std::sqrt(n), 1.0 / std::sqrt(n)}, {FFTNorm::None, 1.0, 1.0}};
+        for (auto [norm, fscale, iscale] : modes) {
+            FFT<double> fft(size);
+            fft.set_shuffle_bits(q);
+            fft.norm = norm;
+            fft.threads = 2;
+            auto y = x;
+            auto s = fft.fft(y);
+            bool same = true;
+            for (size_t i = 0; i < size; i++) {
+                complex<double> e(fscale * eview[i].re, fscale * eview[i].im);
+                same = same && tutil::eq(s[i], e);
+            }
+            EXPECT_TRUE(same);
+
+            s = fft.ifft(s);
+            same = true;
+            double total = fscale * iscale * n;
+            for (size_t i = 0; i < size; i++) {
+                complex<double> e(total * xview[i].re, total * xview[i].im);
+                same = same && tutil::eq(s[i], e);
+            }
+            EXPECT_TRUE(same);
+        }
+    }
+}
+
+UTEST(FFTTests, TestOutOfPlace) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    for (size_t size = 1; size <= util::pow2(16); size *= 2) {
+        FFT<double> fft(size);
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> out{size};
+        Vec<complex<double>> back{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = ampgen(engine);
+            x.idata()[i] = ampgen(engine);
+        }
+        auto orig = x;
+        auto expected = x;
+        fft.fft(expected);
+
+        auto s = fft.fft(ConstView<complex<double>>(x), out);
+        auto eview = tview::view(expected);
+        bool same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && tutil::eq(s[i], eview[i]);
+            same = same && x.rdata()[i] == orig.rdata()[i] && x.idata()[i] == orig.idata()[i];
+        }
+        EXPECT_TRUE(same);
+
+        auto b = fft.ifft(ConstView<complex<double>>(out), back);
+        auto oview = tview::view(orig);
+        same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && tutil::eq(b[i], oview[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(FFTTests, TestCallbacks) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // No layers past the shuffle, both parities of radix-4 layers and recursive splits, with and without threads
+    std::tuple<size_t, size_t, size_t> cases[] = {{1, 5, 1}, {2, 5, 1}, {64, 5, 1}, {256, 2, 1}, 
+        {1 << 12, 5, 1}, {FFT<double>::RECURSE_BLOCK * 2, 5, 1}, {FFT<double>::RECURSE_BLOCK * 4, 5, 3}};
+    for (auto [size, q, threads] : cases) {
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> window{size};
+        Vec<complex<double>> gain{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = ampgen(engine);
+            x.idata()[i] = ampgen(engine);
+            window.rdata()[i] = 0.5 - 0.5 * std::cos(2 * std::numbers::pi * i / size);
+            window.idata()[i] = 0.0;
+            gain.rdata()[i] = ampgen(engine);
+            gain.idata()[i] = ampgen(engine);
+        }
+        MultFunction<complex<double>> wfunc(window);
+        MultFunction<complex<double>> gfunc(gain);
+
+        // Every element must be seen once by each callback
+        std::vector<int> loads(size), stores(size);
+        auto load = [&](size_t offset, MutView<complex<double>> chunk) {
+            for (size_t i = 0; i < chunk.size(); i++) loads[offset + i]++;
+            wfunc(offset, chunk);
+        };
+        auto store = [&](size_t offset, MutView<complex<double>> chunk) {
+            for (size_t i = 0; i < chunk.size(); i++) stores[offset + i]++;
+            gfunc(offset, chunk);
+        };
+        auto counted = [&]() {
+            bool once = true;
+            for (size_t i = 0; i < size; i++) {
+                once = once && loads[i] == 1 && stores[i] == 1;
+            }
+            std::fill(loads.begin(), loads.end(), 0);
+            std::fill(stores.begin(), stores.end(), 0);
+            return once;
+        };
+
+        for (auto mode : {FFTMode::Recursive, FFTMode::BreadthFirst}) {
+            FFT<double> fft(size);
+            fft.set_shuffle_bits(q);
+            fft.mode = mode;
+            fft.threads = threads;
+
+            auto expected = x;
+            wfunc(expected);
+            fft.fft(expected);
+            gfunc(expected);
+            auto y = x;
+            fft.fft(y, load, store);
+            EXPECT_TRUE(counted());
+            bool same = true;
+            for (size_t i = 0; i < size; i++) {
+                same = same && tutil::eq(tview::view(y)[i], tview::view(expected)[i]);
+            }
+            EXPECT_TRUE(same);
+
+            expected = x;
+            wfunc(expected);
+            fft.ifft(expected);
+            gfunc(expected);
+            y = x;
+            fft.ifft(y, load, store);
+            EXPECT_TRUE(counted());
+            same = true;
+            for (size_t i = 0; i < size; i++) {
+                same = same && tutil::eq(tview::view(y)[i], tview::view(expected)[i]);
+            }
+            EXPECT_TRUE(same);
+        }
+    }
+}
+
+UTEST(FFTTests, TestCompactTwiddles) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // The derived factors are the stored ones, so the results should match exactly
+    size_t size = 8 * TwiddleTable<double>::COMPACT_FULL;
+    FFT<double> full(size);
+    FFT<double> compact(size, true, TwiddleMode::Compact);
+    Vec<complex<double>> x{size};
+    Vec<complex<double>> y{size};
+    Vec<complex<double>> work{size};
+    for (size_t i = 0; i < size; i++) {
+        x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+        x.idata()[i] = y.idata()[i] = ampgen(engine);
+    }
+
+    auto same = [&]() {
+        bool eq = true;
+        for (size_t i = 0; i < size; i++) {
+            eq = eq && x.rdata()[i] == y.rdata()[i] && x.idata()[i] == y.idata()[i];
+        }
+        return eq;
+    };
+
+    for (auto mode : {FFTMode::Recursive, FFTMode::BreadthFirst}) {
+        full.mode = compact.mode = mode;
+        full.fft(x);
+        compact.fft(y);
+        EXPECT_TRUE(same());
+        full.ifft(x);
+        compact.ifft(y);
+        EXPECT_TRUE(same());
+    }
+
+    full.fft_autosort(x, work);
+    compact.fft_autosort(y, work);
+    EXPECT_TRUE(same());
+    full.ifft_autosort(x, work);
+    compact.ifft_autosort(y, work);
+    EXPECT_TRUE(same());
+}
+
+UTEST(FFTTests, TestAutosortMatchesFFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    for (size_t size = 1; size <= 4096; size *= 2) {
+        FFT<double> fft(size);
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> y{size};
+        Vec<complex<double>> work{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+            x.idata()[i] = y.idata()[i] = ampgen(engine);
+        }
+        auto orig = x;
+
+        auto as = fft.fft_autosort(x, work);
+        auto s = fft.fft(y);
+        EXPECT_TRUE(tutil::random_eq(as.data(), s.data(), size));
+
+        as = fft.ifft_autosort(as, work);
+        EXPECT_TRUE(tutil::random_eq(as.data(), tview::view(orig).data(), size));
+    }
+}
+
+UTEST(FFTTests, TestFloatMatchesDouble) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    for (size_t size = 1; size <= util::pow2(16); size *= 2) {
+        FFT<float> ffft(size);
+        FFT<double> dfft(size);
+        Vec<complex<float>> x{size};
+        Vec<complex<double>> y{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+            x.idata()[i] = y.idata()[i] = ampgen(engine);
+        }
+
+        // Single precision loses about log2(size) bits against the magnitude of the output
+        double tol = 1e-5 * std::sqrt(1.0 * size) * 10.0 * (1 + shuffle::num_bits(size));
+        auto fs = ffft(x);
+        auto ds = dfft(y);
+        bool same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && std::abs(fs[i].re - ds[i].re) < tol && std::abs(fs[i].im - ds[i].im) < tol;
+        }
+        EXPECT_TRUE(same);
+
+        fs = ffft.ifft(fs);
+        ds = dfft.ifft(ds);
+        same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && std::abs(fs[i].re - ds[i].re) < 1e-4 && std::abs(fs[i].im - ds[i].im) < 1e-4;
+        }
+        EXPECT_TRUE(same);
+    }
 }
@@ -0,0 +1,95 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <fftnd.h>
+
+// Naive DFT of a d0 x d1 x d2 grid at (k0, k1, k2)
+static complex<double> dft3(const Vec<complex<double>>& x, size_t d0, size_t d1, size_t d2, size_t k0, size_t k1, size_t k2) {
+    complex<double> sum{0.0, 0.0};
+    for (size_t n0 = 0; n0 < d0; n0++) {
+        for (size_t n1 = 0; n1 < d1; n1++) {
+            for (size_t n2 = 0; n2 < d2; n2++) {
+                double angle = -2.0 * std::numbers::pi * 
+                    (1.0 * (k0 * n0 % d0) / d0 + 1.0 * (k1 * n1 % d1) / d1 + 1.0 * (k2 * n2 % d2) / d2);
+                size_t i = (n0 * d1 + n1) * d2 + n2;
+                sum.re += x.rdata()[i] * cos(angle) - x.idata()[i] * sin(angle);
+                sum.im += x.rdata()[i] * sin(angle) + x.idata()[i] * cos(angle);
+            }
+        }
+    }
+    return sum;
+}
+
+UTEST(FFTNDTests, TestAgainstDFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // 2D grids are 3D grids with a leading 1
+    for (auto [d0, d1, d2] : {std::tuple{1, 8, 16}, std::tuple{1, 32, 4}, std::tuple{4, 8, 2}, std::tuple{8, 1, 64}, std::tuple{2, 16, 8}}) {
+        size_t size = d0 * d1 * d2;
+        FFTND<double> fft{size_t(d0), size_t(d1), size_t(d2)};
+        Vec<complex<double>> x{size_t(d0), size_t(d1), size_t(d2)};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = ampgen(engine);
+            x.idata()[i] = ampgen(engine);
+        }
+        auto orig = x;
+
+        auto s = fft.fft(x);
+        bool same = true;
+        for (size_t i = 0; i < size; i++) {
+            size_t k2 = i % d2, k1 = (i / d2) % d1, k0 = i / (d1 * d2);
+            auto expected = dft3(orig, d0, d1, d2, k0, k1, k2);
+            same = same && tutil::eq(s[i].re, expected.re) && tutil::eq(s[i].im, expected.im);
+        }
+        EXPECT_TRUE(same);
+
+        s = fft.ifft(s);
+        auto oview = tview::view(orig);
+        for (size_t i = 0; i < size; i++) {
+            same = same && tutil::eq(s[i], oview[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(FFTNDTests, TestSingleAxis) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Every column of a 2D grid against the one dimensional transform
+    const size_t rows = 64, cols = 8;
+    FFTND<double> fft{rows, cols};
+    FFT<double> column_fft(rows);
+    Vec<complex<double>> x{rows, cols};
+    for (size_t i = 0; i < rows * cols; i++) {
+        x.rdata()[i] = ampgen(engine);
+        x.idata()[i] = ampgen(engine);
+    }
+    auto orig = x;
+
+    auto s = fft.fft_axis(x, 0);
+    bool same = true;
+    for (size_t c = 0; c < cols; c++) {
+        Vec<complex<double>> column{rows};
+        for (size_t i = 0; i < rows; i++) {
+            column.rdata()[i] = orig.rdata()[i * cols + c];
+            column.idata()[i] = orig.idata()[i * cols + c];
+        }
+        auto cs = column_fft.fft(column);
+        for (size_t i = 0; i < rows; i++) {
+            same = same && tutil::eq(s[i * cols + c], cs[i]);
+        }
+    }
+    EXPECT_TRUE(same);
+
+    s = fft.ifft_axis(s, 0);
+    auto oview = tview::view(orig);
+    for (size_t i = 0; i < rows * cols; i++) {
+        same = same && tutil::eq(s[i], oview[i]);
+    }
+    EXPECT_TRUE(same);
+}
@@ -0,0 +1,57 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <fixedfft.h>
+#include <fft.h>
+
+template <size_t N>
+static bool fixed_matches_fft() {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    FixedFFT<double, N> fixed;
+    FFT<double> fft(N);
+    Vec<complex<double>> x{N};
+    Vec<complex<double>> y{N};
+    for (size_t i = 0; i < N; i++) {
+        x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+        x.idata()[i] = y.idata()[i] = ampgen(engine);
+    }
+    auto orig = x;
+
+    fixed.fft(x);
+    fft.fft(y);
+    auto xview = tview::view(x);
+    auto yview = tview::view(y);
+    bool same = true;
+    for (size_t i = 0; i < N; i++) {
+        same = same && tutil::eq(xview[i], yview[i]);
+    }
+
+    fixed.ifft(x);
+    auto oview = tview::view(orig);
+    for (size_t i = 0; i < N; i++) {
+        same = same && tutil::eq(xview[i], oview[i]);
+    }
+    return same;
+}
+
+UTEST(FixedFFTTests, TestMatchesFFT) {
+    EXPECT_TRUE(fixed_matches_fft<8>());
+    EXPECT_TRUE(fixed_matches_fft<16>());
+    EXPECT_TRUE(fixed_matches_fft<32>());
+    EXPECT_TRUE(fixed_matches_fft<64>());
+}
+
+UTEST(FixedFFTTests, TestTwiddles) {
+    // The compile time factors should agree with the library trig to rounding
+    bool same = true;
+    for (size_t e = 0; e < 64; e++) {
+        auto [c, s] = codelet::_unit(8 * e, 8 * 64);
+        double angle = 2.0 * std::numbers::pi * (1.0 * e) / 64.0;
+        same = same && std::abs(c - cos(angle)) < 1e-15 && std::abs(s - sin(angle)) < 1e-15;
+    }
+    EXPECT_TRUE(same);
+}
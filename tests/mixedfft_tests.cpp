@@ -0,0 +1,48 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <mixedfft.h>
+
+UTEST(MixedRadixTests, TestSupportedSizes) {
+    EXPECT_TRUE(MixedRadixFFT<double>::supports(1));
+    EXPECT_TRUE(MixedRadixFFT<double>::supports(1536));
+    EXPECT_TRUE(MixedRadixFFT<double>::supports(3000));
+    EXPECT_TRUE(MixedRadixFFT<double>::supports(6000));
+    EXPECT_TRUE(MixedRadixFFT<double>::supports(7 * 5 * 3 * 2));
+    EXPECT_FALSE(MixedRadixFFT<double>::supports(0));
+    EXPECT_FALSE(MixedRadixFFT<double>::supports(11));
+    EXPECT_FALSE(MixedRadixFFT<double>::supports(2 * 13));
+}
+
+UTEST(MixedRadixTests, TestAgainstDFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    for (size_t size : {1, 2, 3, 5, 6, 7, 12, 15, 35, 60, 105, 375, 840, 1536, 3000, 6000}) {
+        MixedRadixFFT<double> fft(size);
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> orig{size};
+
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = orig.rdata()[i] = ampgen(engine);
+            x.idata()[i] = orig.idata()[i] = ampgen(engine);
+        }
+
+        auto s = fft(x);
+
+        EXPECT_TRUE(tutil::random_check<complex<double>>(s.data(), size, [&orig, size](size_t k) {
+            complex<double> sum{0.0, 0.0};
+            for (size_t n = 0; n < size; n++) {
+                double angle = -2.0 * std::numbers::pi * (1.0 * ((k * n) % size)) / (1.0 * size);
+                sum.re += orig.rdata()[n] * cos(angle) - orig.idata()[n] * sin(angle);
+                sum.im += orig.rdata()[n] * sin(angle) + orig.idata()[n] * cos(angle);
+            }
+            return sum;
+        }));
+
+        s = fft.ifft(s);
+        EXPECT_TRUE(tutil::random_eq(s.data(), tview::view(orig).data(), size));
+    }
+}
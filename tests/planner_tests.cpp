@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <utest.h>
+#include "test_utils.h"
+#include <planner.h>
+
+UTEST(PlannerTests, TestPlannedFFTMatches) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    FFTPlanner<double> planner(2, std::chrono::milliseconds(1));
+    for (size_t size : {size_t(16), size_t(4096), FFT<double>::RECURSE_BLOCK * 2}) {
+        auto planned = planner.make(size);
+        EXPECT_TRUE(planner.known(size));
+        FFT<double> fft(size);
+
+        Vec<complex<double>> x{size};
+        Vec<complex<double>> y{size};
+        for (size_t i = 0; i < size; i++) {
+            x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+            x.idata()[i] = y.idata()[i] = ampgen(engine);
+        }
+
+        auto ps = planned.fft(x);
+        auto fs = fft.fft(y);
+        bool same = true;
+        for (size_t i = 0; i < size; i++) {
+            same = same && tutil::eq(ps[i], fs[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(PlannerTests, TestWisdomRoundTrip) {
+    auto path = (std::filesystem::temp_directory_path() / "ctl_planner_test.wisdom").string();
+
+    FFTPlanner<double> planner(1, std::chrono::milliseconds(1));
+    FFTPlan custom;
+    custom.mode = FFTMode::BreadthFirst;
+    custom.shuffle_bits = 4;
+    custom.threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    planner.remember(1 << 20, custom);
+    planner.plan(256);
+    EXPECT_TRUE(planner.save(path));
+
+    FFTPlanner<double> loaded(1, std::chrono::milliseconds(1));
+    EXPECT_TRUE(loaded.load(path));
+    EXPECT_TRUE(loaded.known(256));
+    EXPECT_TRUE(loaded.known(1 << 20));
+    EXPECT_TRUE(loaded.plan(1 << 20) == custom);
+    EXPECT_TRUE(loaded.plan(256) == planner.plan(256));
+
+    // Malformed files are rejected without changing the known plans
+    // 10 has no two adjacent bits set, which a test of a & (a >> 1) let through
+    FFTPlanner<double> rejected(1, std::chrono::milliseconds(1));
+    for (size_t size : {1000, 10}) {
+        {
+            std::ofstream out(path);
+            out << FFTPlanner<double>::header() << "\n" << size << " 1 1 1\n";
+        }
+        EXPECT_FALSE(rejected.load(path));
+        EXPECT_FALSE(rejected.known(size));
+    }
+    EXPECT_FALSE(rejected.load(path + ".missing"));
+
+    // And so are block sizes and thread counts out of range, the largest 
+    // block size of 2^10 is 5 and the last line asks for a thread per 2^20 cores
+    for (const char* plan : {"1024 1 6 1\n", "1024 1 64 1\n", "1024 1 5 0\n", "1024 1 5 1048576\n"}) {
+        {
+            std::ofstream out(path);
+            out << FFTPlanner<double>::header() << "\n" << plan;
+        }
+        EXPECT_FALSE(rejected.load(path));
+        EXPECT_FALSE(rejected.known(1024));
+    }
+
+    // So are plans of another precision or SIMD backend
+    for (const char* header : {"ctl-wisdom 2 f32 avx2", "ctl-wisdom 2 f64 other", "ctl-wisdom 1"}) {
+        {
+            std::ofstream out(path);
+            out << header << "\n" << "1024 1 5 1\n";
+        }
+        EXPECT_FALSE(rejected.load(path));
+        EXPECT_FALSE(rejected.known(1024));
+    }
+
+    std::remove(path.c_str());
+}
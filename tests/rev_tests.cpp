@@ -1,6 +1,8 @@
 #include "tests/test_utils.h"
 #include <utest.h>
 #include <shuffler.h>
+#include <numbers>
+#include <cmath>
 
 UTEST(BitReversalTests, TestBase) {
     Vec<int> t{1};
@@ -104,3 +106,78 @@ UTEST(BitReversalTests, TestComplex) {
     EXPECT_TRUE(tutil::ceq(data[0b1111], complex<double>{15.0, 30.0}));
 }
 
+
+UTEST(BitReversalTests, TestFusedLayers) {
+    // Every block of 2^F reversed elements becomes the DFT of the block in natural order
+    const size_t n = 1 << 12;
+    for (size_t q : {3, 4, 5}) {
+        Vec<complex<double>> x{n};
+        for (size_t i = 0; i < n; i++) {
+            x.rdata()[i] = std::sin(1.0 * i);
+            x.idata()[i] = std::cos(3.0 * i);
+        }
+        auto plain = x;
+        auto orig = x;
+
+        ShuffleFunction<complex<double>> shuffle(n, q);
+        size_t f = shuffle.fused_layers();
+        size_t fs = util::pow2(f);
+        EXPECT_EQ(f, (q >= 5) ? 5u : 3u);
+        shuffle(x, 1, ShuffleFusion::Forward);
+        shuffle(plain, 1);
+
+        bool same = true;
+        for (size_t s = 0; s < n; s += fs) {
+            for (size_t k = 0; k < fs; k++) {
+                double re = 0.0, im = 0.0;
+                for (size_t i = 0; i < fs; i++) {
+                    size_t src = s + shuffle::rev_int(i, f);
+                    double angle = -2.0 * std::numbers::pi * (1.0 * ((i * k) % fs)) / (1.0 * fs);
+                    re += plain.rdata()[src] * std::cos(angle) - plain.idata()[src] * std::sin(angle);
+                    im += plain.rdata()[src] * std::sin(angle) + plain.idata()[src] * std::cos(angle);
+                }
+                same = same && tutil::eq(x.rdata()[s + k], re) && tutil::eq(x.idata()[s + k], im);
+            }
+        }
+        EXPECT_TRUE(same);
+
+        // The inverse undoes it up to the factor of 2^F
+        shuffle(x, 1, ShuffleFusion::Inverse);
+        for (size_t i = 0; i < n; i++) {
+            same = same && tutil::eq(x.rdata()[i], fs * orig.rdata()[i]) && tutil::eq(x.idata()[i], fs * orig.idata()[i]);
+        }
+        EXPECT_TRUE(same);
+    }
+}
+
+UTEST(BitReversalTests, TestOutOfPlace) {
+    // Swapped and unfused COBRA shuffles, the fused ones are covered through the FFT
+    for (auto [n, q] : {std::pair<size_t, size_t>{1, 5}, {64, 5}, {1 << 12, 2}}) {
+        Vec<complex<double>> x{n};
+        Vec<complex<double>> out{n};
+        Vec<complex<double>> neg{n};
+        for (size_t i = 0; i < n; i++) {
+            x.rdata()[i] = 1.0 * i;
+            x.idata()[i] = -2.0 * i;
+        }
+        auto plain = x;
+        auto orig = x;
+
+        ShuffleFunction<complex<double>> shuffle(n, q);
+        shuffle(plain, 1);
+        shuffle(ConstView<complex<double>>(x), out, 1, ShuffleFusion::None, 0.5);
+        shuffle(ConstView<complex<double>>(x), neg, 1, ShuffleFusion::None, 1.0, true);
+
+        bool same = true;
+        size_t bits = shuffle::num_bits(n);
+        for (size_t i = 0; i < n; i++) {
+            same = same && tutil::eq(out.rdata()[i], 0.5 * plain.rdata()[i]) && tutil::eq(out.idata()[i], 0.5 * plain.idata()[i]);
+            // in[-rev(i) mod n]
+            size_t src = (n - ((bits == 0) ? i : shuffle::rev_int(i, bits))) & (n - 1);
+            same = same && tutil::eq(neg.rdata()[i], orig.rdata()[src]) && tutil::eq(neg.idata()[i], orig.idata()[src]);
+            // The input is left alone
+            same = same && x.rdata()[i] == orig.rdata()[i] && x.idata()[i] == orig.idata()[i];
+        }
+        EXPECT_TRUE(same);
+    }
+}
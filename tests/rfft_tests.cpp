@@ -0,0 +1,35 @@
+#include <numbers>
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <rfft.h>
+
+UTEST(RFFTTests, TestAgainstComplexFFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    for (size_t size : {4, 8, 16, 32, 256, 2048, 1 << 15}) {
+        RFFT<double> rfft(size);
+        FFT<double> fft(size);
+        Vec<double> x{size};
+        Vec<double> back{size};
+        Vec<complex<double>> X{size / 2 + 1};
+        Vec<complex<double>> ref{size};
+
+        for (size_t i = 0; i < size; i++) {
+            x.data()[i] = ref.rdata()[i] = ampgen(engine);
+            ref.idata()[i] = 0.0;
+        }
+
+        rfft.fft(x, X);
+        fft.fft(ref);
+
+        EXPECT_TRUE(tutil::random_eq(tview::view(X).data(), tview::view(ref).data(), size / 2 + 1));
+        EXPECT_TRUE(tutil::eq(X.rdata()[size / 2], ref.rdata()[size / 2]));
+        EXPECT_TRUE(tutil::eq(X.idata()[size / 2], 0.0));
+
+        rfft.ifft(X, back);
+        EXPECT_TRUE(tutil::random_eq(back.data(), x.data(), size));
+    }
+}
@@ -0,0 +1,42 @@
+#include <random>
+#include <utest.h>
+#include "test_utils.h"
+#include <sixstep.h>
+
+UTEST(SixStepTests, TestMatchesFFT) {
+    std::random_device r;
+    std::default_random_engine engine(r());
+    std::uniform_real_distribution ampgen(-10.0, 10.0);
+
+    // Square and rectangular splits, with and without threads
+    for (size_t size : {16, 32, 64, 512, 1 << 12, 1 << 15, 1 << 18}) {
+        for (size_t threads : {1, 3}) {
+            SixStepFFT<double> sixstep(size);
+            FFT<double> fft(size);
+            sixstep.threads = threads;
+
+            Vec<complex<double>> x{size};
+            Vec<complex<double>> y{size};
+            for (size_t i = 0; i < size; i++) {
+                x.rdata()[i] = y.rdata()[i] = ampgen(engine);
+                x.idata()[i] = y.idata()[i] = ampgen(engine);
+            }
+            auto orig = x;
+
+            auto ss = sixstep.fft(x);
+            auto fs = fft.fft(y);
+            bool same = true;
+            for (size_t i = 0; i < size; i++) {
+                same = same && tutil::eq(ss[i], fs[i]);
+            }
+            EXPECT_TRUE(same);
+
+            ss = sixstep.ifft(ss);
+            auto oview = tview::view(orig);
+            for (size_t i = 0; i < size; i++) {
+                same = same && tutil::eq(ss[i], oview[i]);
+            }
+            EXPECT_TRUE(same);
+        }
+    }
+}
@@ -2,6 +2,11 @@
 #include <twiddle.h>
 #include "test_utils.h"
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <numbers>
+#include <thread>
+#include <vector>
 
 UTEST(TwiddleTests, TestLayers) {
     const TwiddleStore<double> twiddles{64};
@@ -28,3 +33,151 @@ UTEST(TwiddleTests, TestLayers) {
     layer = twiddles.get_layer(2);
     EXPECT_TRUE(tutil::eq(layer[0], complex<double>{1.0, 0.0}));
 }
+
+template <typename T>
+static double max_twiddle_error(size_t n) {
+    const TwiddleTable<T> table{n};
+    double err = 0;
+    auto layer = table.get_layer(n);
+    for (size_t k = 0; k < n / 2; k++) {
+        double angle = -2.0 * std::numbers::pi * (1.0 * k) / (1.0 * n);
+        err = std::max({err, std::abs(layer.data().re[k] - cos(angle)), std::abs(layer.data().im[k] - sin(angle))});
+    }
+    auto cube = table.get_cube_layer(n);
+    for (size_t k = 0; k < n / 4; k++) {
+        double angle = -2.0 * std::numbers::pi * (3.0 * k) / (1.0 * n);
+        err = std::max({err, std::abs(cube.data().re[k] - cos(angle)), std::abs(cube.data().im[k] - sin(angle))});
+    }
+    return err;
+}
+
+UTEST(TwiddleTests, TestAccuracy) {
+    // Every factor of the last layers should be within about an ulp of T
+    for (size_t n : {util::pow2(3), util::pow2(10), util::pow2(17)}) {
+        EXPECT_LT(max_twiddle_error<float>(n), 6.5e-8);
+        EXPECT_LT(max_twiddle_error<double>(n), 1e-15);
+    }
+}
+
+template <typename T>
+static bool compact_matches_full(size_t n) {
+    const TwiddleTable<T> full{n};
+    const TwiddleTable<T> compact{n, TwiddleMode::Compact};
+    if (compact.stored() != TwiddleTable<T>::COMPACT_FULL) return false;
+
+    Vec<complex<T>> buf{n / 2};
+    bool same = true;
+    for (size_t m = 4; m <= n; m *= 2) {
+        MutView<complex<T>> out(buf, 0, m / 2);
+        compact.load_layer(m, 0, out);
+        auto layer = full.get_layer(m);
+        for (size_t k = 0; k < m / 2; k++) {
+            same = same && out.data().re[k] == layer.data().re[k] && out.data().im[k] == layer.data().im[k];
+        }
+
+        // An offset block crossing the end of the first octant
+        if (m >= 16) {
+            size_t lo = m / 8 - 1;
+            MutView<complex<T>> part(buf, 0, 3);
+            compact.load_layer(m, lo, part);
+            for (size_t k = 0; k < 3; k++) {
+                same = same && part.data().re[k] == layer.data().re[lo + k] && part.data().im[k] == layer.data().im[lo + k];
+            }
+        }
+
+        MutView<complex<T>> cout(buf, 0, m / 4);
+        compact.load_cube_layer(m, 0, cout);
+        auto cube = full.get_cube_layer(m);
+        for (size_t k = 0; k < m / 4; k++) {
+            same = same && cout.data().re[k] == cube.data().re[k] && cout.data().im[k] == cube.data().im[k];
+        }
+    }
+    return same;
+}
+
+UTEST(TwiddleTests, TestCompactLayers) {
+    EXPECT_TRUE(compact_matches_full<float>(util::pow2(17)));
+    EXPECT_TRUE(compact_matches_full<double>(util::pow2(17)));
+}
+
+UTEST(TwiddleTests, TestThreadedBuild) {
+    // The factors do not depend on how the layers were split between threads
+    size_t n = util::pow2(17);
+    for (auto mode : {TwiddleMode::Full, TwiddleMode::Compact}) {
+        const TwiddleTable<double> serial{n, mode, 1};
+        const TwiddleTable<double> threaded{n, mode, 4};
+        auto a = serial.get_layer(serial.stored());
+        auto b = threaded.get_layer(threaded.stored());
+        EXPECT_TRUE(std::equal(a.data().re, a.data().re + a.size(), b.data().re));
+        EXPECT_TRUE(std::equal(a.data().im, a.data().im + a.size(), b.data().im));
+        auto ca = serial.get_cube_layer(serial.stored());
+        auto cb = threaded.get_cube_layer(threaded.stored());
+        EXPECT_TRUE(std::equal(ca.data().re, ca.data().re + ca.size(), cb.data().re));
+        EXPECT_TRUE(std::equal(ca.data().im, ca.data().im + ca.size(), cb.data().im));
+
+        Vec<complex<double>> x{n / 2}, y{n / 2};
+        serial.load_layer(n, 0, MutView<complex<double>>(x, 0, n / 2));
+        threaded.load_layer(n, 0, MutView<complex<double>>(y, 0, n / 2));
+        EXPECT_TRUE(std::equal(x.rdata(), x.rdata() + n / 2, y.rdata()));
+        EXPECT_TRUE(std::equal(x.idata(), x.idata() + n / 2, y.idata()));
+    }
+}
+
+UTEST(TwiddleTests, TestSharedTables) {
+    const TwiddleStore<double> small{256};
+    auto before = small.get_layer(256);
+    auto re = before.data().re;
+
+    // Larger transforms publish their own table, the views of the existing ones stay put
+    const TwiddleStore<double> large{util::pow2(16)};
+    const TwiddleStore<double> other{256};
+    EXPECT_EQ(small.get_layer(256).data().re, re);
+    EXPECT_EQ(other.get_layer(256).data().re, re);
+
+    double angle = -2.0 * std::numbers::pi * 3.0 / 256.0;
+    EXPECT_TRUE(tutil::eq(before[3], complex<double>{cos(angle), sin(angle)}));
+    EXPECT_TRUE(tutil::eq(large.get_layer(256)[3], complex<double>{cos(angle), sin(angle)}));
+}
+
+UTEST(TwiddleTests, TestLargeTablesReleased) {
+    // Tables above COMPACT_FULL are shared while in use, and freed with their last user
+    const size_t n = util::pow2(16);
+    std::weak_ptr<const TwiddleTable<double>> table;
+    {
+        const TwiddleStore<double> a{n};
+        const TwiddleStore<double> b{n};
+        EXPECT_EQ(a.get_layer(n).data().re, b.get_layer(n).data().re);
+        table = TwiddleRegistry<double>::get(n);
+        EXPECT_FALSE(table.expired());
+    }
+    EXPECT_TRUE(table.expired());
+
+    // The smaller ones are kept
+    auto kept = TwiddleRegistry<double>::get(TwiddleTable<double>::COMPACT_FULL);
+    EXPECT_EQ(TwiddleRegistry<double>::get(TwiddleTable<double>::COMPACT_FULL).get(), kept.get());
+}
+
+UTEST(TwiddleTests, TestConcurrentConstruction) {
+    // Every thread asks for the sizes in a different order
+    const size_t threads = 8;
+    std::vector<std::thread> pool;
+    std::atomic<size_t> wrong{0};
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back([t, &wrong] {
+            for (size_t i = 0; i < 12; i++) {
+                size_t n = util::pow2(4 + (i + 5 * t) % 12);
+                const TwiddleStore<float> twiddles{n};
+                auto layer = twiddles.get_layer(n);
+                size_t k = n / 4 - 1;
+                double angle = -2.0 * std::numbers::pi * (1.0 * k) / (1.0 * n);
+                if (std::abs(layer.data().re[k] - cos(angle)) > 1e-5 || std::abs(layer.data().im[k] - sin(angle)) > 1e-5) {
+                    wrong++;
+                }
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong.load(), 0u);
+}
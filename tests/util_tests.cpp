@@ -1,6 +1,11 @@
 #include <utest.h>
 #include "test_utils.h"
 #include <common.h>
+#include <parallel.h>
+#include <atomic>
+#include <bit>
+#include <stdexcept>
+#include <vector>
 
 UTEST(UtilTests, TestComplexSwap) {
     complex<double> a{1.0, 5.0};
@@ -18,3 +23,52 @@ UTEST(UtilTests, TestComplexSwap) {
 
 }
 
+
+UTEST(UtilTests, TestIsPow2) {
+    bool same = true;
+    for (size_t n = 0; n < 4096; n++) {
+        same = same && util::is_pow2(n) == std::has_single_bit(n);
+    }
+    EXPECT_TRUE(same);
+}
+
+UTEST(UtilTests, TestParallelFor) {
+    // Every index once, with nested calls as the recursive transforms make them
+    const size_t n = 1000;
+    std::vector<std::atomic<int>> hits(n * n);
+    util::parallel_for(4, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            util::parallel_for(3, n, [&](size_t b, size_t e) {
+                for (size_t j = b; j < e; j++) hits[i * n + j]++;
+            });
+        }
+    });
+    bool once = true;
+    for (auto& h : hits) {
+        once = once && h == 1;
+    }
+    EXPECT_TRUE(once);
+
+    // The workers are kept for the next calls
+    size_t workers = util::ThreadPool::shared().size();
+    util::parallel_for(4, n, [](size_t, size_t) {});
+    EXPECT_EQ(util::ThreadPool::shared().size(), workers);
+
+    // Nor grown past the cores, however many chunks a call asks for
+    util::parallel_for(4 * util::ThreadPool::max_threads() + 8, n, [](size_t, size_t) {});
+    EXPECT_TRUE(util::ThreadPool::shared().size() < util::ThreadPool::max_threads());
+
+    // Exceptions reach the caller, after every chunk is done
+    std::atomic<int> done = 0;
+    bool caught = false;
+    try {
+        util::parallel_for(4, n, [&](size_t begin, size_t) {
+            done++;
+            if (begin == 0) throw std::runtime_error("chunk");
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    EXPECT_TRUE(caught);
+    EXPECT_EQ(done.load(), 4);
+}